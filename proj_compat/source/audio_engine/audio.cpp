@@ -46,7 +46,12 @@ AudioEngine::AudioEngine () :
 	_context(0),
 	_max_sources(MAX_DEFAULT_AUDIO_SOURCES),
 	_active_music(NULL),
-	_max_cache_size(MAX_DEFAULT_AUDIO_SOURCES / 4)
+	_max_cache_size(MAX_DEFAULT_AUDIO_SOURCES / 4),
+	_cache_budget(DEFAULT_AUDIO_CACHE_BUDGET),
+	_cache_resident_bytes(0),
+	_cache_hits(0),
+	_cache_misses(0),
+	_cache_evictions(0)
 {}
 
 
@@ -380,7 +385,7 @@ bool AudioEngine::LoadMusic(const std::string& filename) {
 
 
 void AudioEngine::PlaySound(const std::string& filename) {
-	map<std::string, AudioCacheElement>::iterator element = _audio_cache.find(filename);
+	map<std::string, AudioCacheElement>::iterator element = _FindResidentAudio(filename);
 
 	if (element == _audio_cache.end()) {
 		if (LoadSound(filename) == false) {
@@ -399,7 +404,7 @@ void AudioEngine::PlaySound(const std::string& filename) {
 
 
 void AudioEngine::PlayMusic(const std::string& filename) {
-	map<std::string, AudioCacheElement>::iterator element = _audio_cache.find(filename);
+	map<std::string, AudioCacheElement>::iterator element = _FindResidentAudio(filename);
 
 	if (element == _audio_cache.end()) {
 		if (LoadMusic(filename) == false) {
@@ -460,7 +465,7 @@ void AudioEngine::ResumeSound(const std::string& filename) {
 
 
 SoundDescriptor* AudioEngine::RetrieveSound(const std::string& filename) {
-	map<std::string, AudioCacheElement>::iterator element = _audio_cache.find(filename);
+	map<std::string, AudioCacheElement>::iterator element = _FindResidentAudio(filename);
 
 	if (element == _audio_cache.end()) {
 		return NULL;
@@ -477,7 +482,7 @@ SoundDescriptor* AudioEngine::RetrieveSound(const std::string& filename) {
 
 
 MusicDescriptor* AudioEngine::RetrieveMusic(const std::string& filename) {
-	map<std::string, AudioCacheElement>::iterator element = _audio_cache.find(filename);
+	map<std::string, AudioCacheElement>::iterator element = _FindResidentAudio(filename);
 
 	if (element == _audio_cache.end()) {
 		return NULL;
@@ -493,6 +498,28 @@ MusicDescriptor* AudioEngine::RetrieveMusic(const std::string& filename) {
 
 
 
+void AudioEngine::SetCacheBudget(uint32 bytes) {
+	_cache_budget = bytes;
+	if (_EnforceCacheLimits(NULL) == false) {
+		IF_PRINT_WARNING(AUDIO_DEBUG) << "the audio cache holds " << _cache_resident_bytes << " bytes, over the new budget of "
+			<< _cache_budget << " bytes, because none of its sounds could be evicted" << endl;
+	}
+}
+
+
+
+AudioCacheStats AudioEngine::GetCacheStats() const {
+	AudioCacheStats stats;
+	stats.hits = _cache_hits;
+	stats.misses = _cache_misses;
+	stats.evictions = _cache_evictions;
+	stats.resident_bytes = _cache_resident_bytes;
+	stats.budget_bytes = _cache_budget;
+	return stats;
+}
+
+
+
 const std::string AudioEngine::CreateALErrorString() {
 	switch (_al_error_code) {
 		case AL_NO_ERROR:
@@ -542,6 +569,9 @@ void AudioEngine::DEBUG_PrintInfo() {
 
 	cout << "Maximum number of sources:   " << _max_sources << endl;
 	cout << "Maximum audio cache size:    " << _max_cache_size << endl;
+	cout << "Audio cache budget:          " << _cache_budget << " bytes (" << _cache_resident_bytes << " used)" << endl;
+	cout << "Audio cache hits/misses:     " << _cache_hits << " / " << _cache_misses << ", "
+		<< _cache_evictions << " evictions" << endl;
 	cout << "Default audio device:        " << alcGetString(_device, ALC_DEFAULT_DEVICE_SPECIFIER) << endl;
 	cout << "OpenAL Version:              " << alGetString(AL_VERSION) << endl;
 	cout << "OpenAL Renderer:             " << alGetString(AL_RENDERER) << endl;
@@ -603,47 +633,97 @@ bool AudioEngine::_LoadAudio(AudioDescriptor* audio, const std::string& filename
 		return false;
 	}
 
-	// (1) If the cache is not full, try loading the audio and adding it in
-	if (_audio_cache.size() < _max_cache_size) {
-		if (audio->LoadAudio(filename) == false) {
-			IF_PRINT_WARNING(AUDIO_DEBUG) << "could not add new audio file into cache because load operation failed: " << filename << endl;
-			return false;
-		}
+	// (1) Load the audio first, since its size is not known until then
+	if (audio->LoadAudio(filename) == false) {
+		IF_PRINT_WARNING(AUDIO_DEBUG) << "could not add new audio file into cache because load operation failed: " << filename << endl;
+		return false;
+	}
+	_cache_misses++;
+
+	// (2) Add it in and evict older audio until the cache is back within its limits
+	map<std::string, AudioCacheElement>::iterator element =
+		_audio_cache.insert(make_pair(filename, AudioCacheElement(hoa_utils::getCurrentTime(), audio))).first;
+	_cache_resident_bytes += element->second.size;
+	if (_EnforceCacheLimits(&element->second) == false) {
+		IF_PRINT_WARNING(AUDIO_DEBUG) << "could not make room in the cache for new audio file: " << filename << endl;
+		_cache_resident_bytes -= element->second.size;
+		_audio_cache.erase(element);
+		audio->FreeAudio();
+		return false;
+	}
 
-		_audio_cache.insert(make_pair(filename, AudioCacheElement(hoa_utils::getCurrentTime(), audio)));
-		return true;
+	return true;
+} // bool AudioEngine::_LoadAudio(AudioDescriptor* audio, const std::string& filename)
+
+
+
+map<std::string, AudioCacheElement>::iterator AudioEngine::_FindResidentAudio(const std::string& filename) {
+	map<std::string, AudioCacheElement>::iterator element = _audio_cache.find(filename);
+
+	if (element == _audio_cache.end()) {
+		return _audio_cache.end();
+	}
+	else if (element->second.resident == true) {
+		_cache_hits++;
+		return element;
 	}
 
-	// (2) The cache is full, so find an element to remove. First make sure that at least one piece of audio is stopped
-	map<std::string, AudioCacheElement>::iterator lru_element = _audio_cache.end();
-	for (map<std::string, AudioCacheElement>::iterator i = _audio_cache.begin(); i != _audio_cache.end(); i++) {
-		if (i->second.audio->GetState() == AUDIO_STATE_STOPPED) {
-			lru_element = i;
-			break;
-		}
+	// The audio was evicted earlier, so load its data back into the same descriptor
+	_cache_misses++;
+	AudioDescriptor* audio = element->second.audio;
+	if (audio->LoadAudio(filename) == false) {
+		IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to reload evicted audio file: " << filename << endl;
+		return _audio_cache.end();
 	}
 
-	if (lru_element == _audio_cache.end()) {
-		IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to remove element from cache because no piece of audio was in the stopped state" << endl;
-		return false;
+	element->second.resident = true;
+	element->second.size = audio->GetMemorySize();
+	_cache_resident_bytes += element->second.size;
+	if (_EnforceCacheLimits(&element->second) == false) {
+		IF_PRINT_WARNING(AUDIO_DEBUG) << "could not make room in the cache to reload audio file: " << filename << endl;
+		audio->FreeAudio();
+		element->second.resident = false;
+		_cache_resident_bytes -= element->second.size;
+		return _audio_cache.end();
 	}
 
-	for (map<std::string, AudioCacheElement>::iterator i = _audio_cache.begin(); i != _audio_cache.end(); i++) {
-		if (i->second.audio->GetState() == AUDIO_STATE_STOPPED && i->second.last_update_time < lru_element->second.last_update_time) {
-			lru_element = i;
+	return element;
+}
+
+
+
+bool AudioEngine::_EnforceCacheLimits(const AudioCacheElement* keep) {
+	while (true) {
+		// Count the resident entries and find the least recently used one that may be evicted:
+		// a static sound which is not playing or paused
+		uint16 resident_entries = 0;
+		map<std::string, AudioCacheElement>::iterator lru_element = _audio_cache.end();
+		for (map<std::string, AudioCacheElement>::iterator i = _audio_cache.begin(); i != _audio_cache.end(); i++) {
+			if (i->second.resident == false)
+				continue;
+			resident_entries++;
+
+			AudioDescriptor* audio = i->second.audio;
+			if (&i->second == keep || audio->IsSound() == false || audio->_stream != NULL || audio->GetState() != AUDIO_STATE_STOPPED)
+				continue;
+			if (lru_element == _audio_cache.end() || i->second.last_update_time < lru_element->second.last_update_time)
+				lru_element = i;
 		}
-	}
 
-	delete lru_element->second.audio;
-	_audio_cache.erase(lru_element);
+		if (resident_entries <= _max_cache_size && _cache_resident_bytes <= _cache_budget)
+			return true;
 
-	if (audio->LoadAudio(filename) == false) {
-		IF_PRINT_WARNING(AUDIO_DEBUG) << "could not add new audio file into cache because load operation failed: " << filename << endl;
-		return false;
-	}
+		if (lru_element == _audio_cache.end()) {
+			IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to evict an element from the cache because no static sound was in the stopped state" << endl;
+			return false;
+		}
 
-	_audio_cache.insert(make_pair(filename, AudioCacheElement(hoa_utils::getCurrentTime(), audio)));
-	return true;
-} // bool AudioEngine::_LoadAudio(AudioDescriptor* audio, const std::string& filename)
+		// Only the data goes, the descriptor stays for RetrieveSound pointers and for reloading
+		lru_element->second.audio->FreeAudio();
+		lru_element->second.resident = false;
+		_cache_resident_bytes -= lru_element->second.size;
+		_cache_evictions++;
+	}
+} // bool AudioEngine::_EnforceCacheLimits(const AudioCacheElement* keep)
 
 } // namespace hoa_audio
@@ -58,23 +58,50 @@ namespace private_audio {
 //! \brief The maximum default number of audio sources that the engine tries to create
 const uint16 MAX_DEFAULT_AUDIO_SOURCES = 64;
 
+//! \brief The default number of bytes that the audio cache may hold (2 MB)
+const uint32 DEFAULT_AUDIO_CACHE_BUDGET = 2 * 1024 * 1024;
 
 
 //! \brief A container class for an element of the LRU audio cache managed by the AudioEngine class
 class AudioCacheElement {
 public:
 	AudioCacheElement(double time, AudioDescriptor* aud) :
-		last_update_time(time), audio(aud) {}
+		last_update_time(time), audio(aud), size(aud->GetMemorySize()), resident(true) {}
 
 	//! \brief Retains the time that the audio was last updated through any operation
 	double last_update_time;
 
 	//! \brief A pointer to the audio descriptor described by the cache element
 	AudioDescriptor* audio;
+
+	//! \brief The number of bytes the audio held when it was last loaded, counted against the cache budget
+	uint32 size;
+
+	/** \brief False once the audio data has been evicted from the cache
+	*** The descriptor itself is kept, so that pointers returned by RetrieveSound remain valid and
+	*** the audio can be reloaded the next time that it is requested.
+	**/
+	bool resident;
 };
 
 } // namespace private_audio
 
+//! \brief Counters describing how well the audio cache is doing, see AudioEngine::GetCacheStats()
+struct AudioCacheStats {
+	//! \brief Requests for audio which was in the cache with its data loaded
+	uint32 hits;
+
+	//! \brief Requests which had to load the audio, either for the first time or after an eviction
+	uint32 misses;
+
+	//! \brief The number of times that audio data was freed to stay within the budget
+	uint32 evictions;
+
+	//! \brief The number of bytes of audio data currently held, and the most that may be held
+	uint32 resident_bytes;
+	uint32 budget_bytes;
+};
+
 /** ****************************************************************************
 *** \brief A singleton class that manages all audio related data and operations
 ***
@@ -275,6 +302,21 @@ public:
 
 	//! \return A pointer to the MusicDescriptor contained within the cache, or NULL if it could not be found
 	MusicDescriptor* RetrieveMusic(const std::string& filename);
+
+	/** \brief Sets the number of bytes of audio data that the cache may hold
+	*** \param bytes The new budget. If the cache holds more than this, stopped sounds are evicted right away.
+	***
+	*** When a load would take the cache over budget, the least recently played static sounds
+	*** which are stopped have their data freed until it fits. Evicted sounds stay in the cache
+	*** and are loaded again the next time they are played or retrieved. Music is never evicted.
+	**/
+	void SetCacheBudget(uint32 bytes);
+
+	uint32 GetCacheBudget() const
+		{ return _cache_budget; }
+
+	//! \brief Returns the cache counters, which are kept since the engine was created
+	AudioCacheStats GetCacheStats() const;
 	//@}
 
 	/** \name Error Detection and Processing methods
@@ -382,6 +424,17 @@ private:
 	**/
 	uint16 _max_cache_size;
 
+	//! \brief The maximum number of bytes that the audio data in the cache may hold
+	uint32 _cache_budget;
+
+	//! \brief The number of bytes held by the resident entries of the audio cache
+	uint32 _cache_resident_bytes;
+
+	//! \brief The hit, miss and eviction counters of the audio cache
+	uint32 _cache_hits;
+	uint32 _cache_misses;
+	uint32 _cache_evictions;
+
 	/** \brief Acquires an available audio source that may be used
 	*** \return A pointer to the available source, or NULL if no available source could be found
 	*** \todo Add an algoihtm to give priority to some sounds/music over others.
@@ -395,6 +448,20 @@ private:
 	*** \note If this function returns false, you should delete the pointer that you passed to it.
 	**/
 	bool _LoadAudio(AudioDescriptor* audio, const std::string& filename);
+
+	/** \brief Finds an element in the audio cache and makes sure that its data is loaded
+	*** \param filename The filename of the audio to look for
+	*** \return An iterator to the element, or the end of the cache if it was not there or could not be reloaded
+	*** This is where the hit and miss counters are kept for audio which the cache already knows of.
+	**/
+	std::map<std::string, private_audio::AudioCacheElement>::iterator _FindResidentAudio(const std::string& filename);
+
+	/** \brief Evicts the least recently used stopped static sounds until the cache is within its limits
+	*** \param keep An element which must not be evicted, such as the one which was just loaded (may be NULL)
+	*** \return True if the cache now has no more than _max_cache_size resident entries and holds no more
+	*** than _cache_budget bytes
+	**/
+	bool _EnforceCacheLimits(const private_audio::AudioCacheElement* keep);
 }; // class AudioEngine : public hoa_utils::Singleton<AudioEngine>
 
 } // namespace hoa_audio
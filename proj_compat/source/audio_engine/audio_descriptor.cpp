@@ -316,12 +316,29 @@ void AudioDescriptor::FreeAudio() {
 
 
 
+uint32 AudioDescriptor::GetMemorySize() const {
+	if (_input == NULL || _buffer == NULL)
+		return 0;
+
+	if (_stream == NULL)
+		return _input->GetDataSize();
+
+	// The OpenAL streaming buffers plus the _data buffer they are filled from
+	uint32 size = _stream_buffer_size * _input->GetSampleSize() * (NUMBER_STREAMING_BUFFERS + 1);
+	if (dynamic_cast<AudioMemory*>(_input) != NULL)
+		size += _input->GetDataSize();
+	return size;
+}
+
+
+
 AUDIO_STATE AudioDescriptor::GetState() {
 	// If the last set state was the playing state, we have to double check
 	// with the OpenAL source to make sure that the audio is still playing.
 	if (_state == AUDIO_STATE_PLAYING) {
-		// If the descriptor no longe
-		if (_source == NULL || _data == NULL) {
+		// If the descriptor no longer holds a source or any buffers it can not be playing.
+		// Static audio frees _data as soon as its buffer is filled, so that is not checked.
+		if (_source == NULL || _buffer == NULL) {
 			_state = AUDIO_STATE_STOPPED;
 		}
 		else {
@@ -212,6 +212,12 @@ public:
 	const std::string GetFilename() const
 		{ if (_input == NULL) return ""; else return _input->GetFilename(); }
 
+	/** \brief Returns the number of bytes that the loaded audio holds on to
+	*** For static audio this is the OpenAL buffer. Streamed audio holds its streaming buffers
+	*** and, when streamed from memory, the whole of the decoded data as well.
+	**/
+	uint32 GetMemorySize() const;
+
 	//! \brief Returns true if this audio represents a sound, false if the audio represents a music piece
 	virtual bool IsSound() const = 0;
 
@@ -24,7 +24,8 @@ enum CIw2DFontAlign
 };
 
 class CIw2DFont {
-  // --
+ public:
+  virtual ~CIw2DFont() { }
 };
 
 void Iw2DInit();
@@ -37,7 +38,17 @@ uint32 Iw2DGetSurfaceWidth();
 void Iw2DSetTransformMatrix(const CIwMat2D &m);
 void Iw2DDrawString(const char* text, CIwSVec2 topLeft, CIwSVec2 size, CIw2DFontAlign horzAlign, CIw2DFontAlign vertAlign);
 void Iw2DDrawImage(CIw2DImage* image, CIwSVec2 topLeft, CIwSVec2 size);
+void Iw2DFillRect(CIwSVec2 topLeft, CIwSVec2 size);
+// compat: static quads kept in a vertex buffer, updated one quad at a
+// time and drawn with one call per image (a NULL image hides the quad)
+class CIw2DQuadBatch;
+CIw2DQuadBatch* Iw2DCreateQuadBatch(int quads);
+void Iw2DSetQuad(CIw2DQuadBatch* batch, int quad, CIw2DImage* image, CIwSVec2 topLeft, CIwSVec2 size);
+void Iw2DDrawQuadBatch(CIw2DQuadBatch* batch);
+void Iw2DDestroyQuadBatch(CIw2DQuadBatch* batch);
 void Iw2DSetFont(const CIw2DFont *f);
+// compat: drop the cached layout of a string no longer drawn with the font
+void Iw2DReleaseString(const CIw2DFont *font, const char* text);
 void Iw2DSetColour(const uint32 color);
 #ifdef __S3E__
 inline static void Iw2DClearScreen(const uint32 color) {
@@ -49,5 +60,20 @@ void Iw2DClearScreen(const uint32 color);
 #endif
 CIw2DImage* Iw2DCreateImageResource(const char* resource);
 CIw2DFont* Iw2DCreateFontResource(const char* resource);
+// compat: bytes of video memory behind an image or a font, padded to what
+// the texture was allocated at; a font counts the texture its copies share,
+// which Iw2DGetFontTexture names so it can be counted once
+uint32 Iw2DGetImageMemSize(CIw2DImage* image);
+uint32 Iw2DGetFontMemSize(CIw2DFont* font);
+uint32 Iw2DGetFontTexture(CIw2DFont* font);
+
+// compat: counters of the work sent to the renderer (the only output
+// when running with SK_HEADLESS=1); binds count texture changes
+struct Iw2DStats {
+  uint32 frames, clears, draws, binds, vertices;
+  uint64 pixels;
+};
+void Iw2DGetStats(Iw2DStats &stats);
+void Iw2DResetStats();
 
 #endif /* __compat_iw2d_h__ */
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <string>
+#include "s3eTypes.h"
 
 void IwResManagerInit();
 inline static void IwResManagerTerminate() { }
@@ -11,14 +12,25 @@ struct CIwResGroup
 {
 };
 
+#define IW_RES_PERMIT_NULL_F (1 << 0)
+
 struct IwGetResManagerS;
 
 static struct IwGetResManagerS 
 {
   std::string group;
   void LoadGroup(const char *grp);
+  // compat: background decode of a group without making it current
+  void PreloadGroup(const char *grp);
+  // compat: 0..1 part of group images ready as textures
+  float GetGroupProgress(const char *grp);
+  // compat: time given to texture uploads in each Iw2DFinishDrawing
+  void SetUploadBudget(uint32 ms);
   int GetNumGroups() { return 0; }
   CIwResGroup *GetGroup(int index) { return NULL; }
+  // no group objects here, LoadGroup is what makes a group current
+  CIwResGroup *GetGroupNamed(const char *grp, uint32 flags = 0) { return NULL; }
+  void SetCurrentGroup(CIwResGroup *g) { }
   void DestroyGroup(CIwResGroup *g) { }
   IwGetResManagerS *operator ()() { return this; }
 } IwGetResManager;
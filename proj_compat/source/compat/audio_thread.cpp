@@ -0,0 +1,469 @@
+#include "audio_thread.h"
+#include "emyl.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdlib.h>
+
+#define AUDIO_COMMANDS 16 // a power of two, so the counters can wrap
+#define AUDIO_PERIOD_MS 10
+#define AUDIO_STACK_SIZE (512*1024) // emyl decodes into a 64k buffer on the stack
+#define AUDIO_PATH_MAX 256
+#define AUDIO_PLAYLIST_MAX 8
+
+enum { _CMD_PLAY, _CMD_QUEUE, _CMD_STOP, _CMD_PAUSE, _CMD_RESUME, _CMD_VOLUME, _CMD_QUIT };
+
+struct _AudioCommand {
+  int type;
+  char path[AUDIO_PATH_MAX];
+  bool loop;
+  bool first; // of a playlist
+  int ms;
+  float volume;
+  unsigned int seq;
+};
+
+// the ring: only the game thread moves _head, only the audio thread _tail
+static _AudioCommand _commands[AUDIO_COMMANDS];
+static volatile unsigned int _head = 0, _tail = 0;
+
+static pthread_t _thread;
+static bool _running = false;
+
+// only QNX makes an AL context for the game (alut, for the effects); on
+// the other platforms the music has OpenAL to itself and opens its own
+static ALCdevice* _device = NULL;
+static ALCcontext* _context = NULL;
+
+// every play gets a number; the game thread knows which one it stopped
+// last, the audio thread reports the last one that played to its end
+static unsigned int _play_seq = 0, _stop_seq = 0;
+static volatile unsigned int _ended_seq = 0;
+static bool _paused = false; // as the game thread last asked
+static volatile unsigned int _underruns = 0;
+static float _volume = 1; // handed to the thread when it starts
+
+// ----- audio thread -----
+
+struct _Music {
+  emyl::stream stream;
+  ALuint source;
+  bool active;
+  bool primed; // the next track, loaded and buffered but silent
+  float gain, from, to;
+  int fade, fadeTime; // ms
+  int played, length; // ms
+  unsigned int seq;
+  unsigned int underruns; // of the stream, already added to _underruns
+};
+
+// tracks played in turn, each crossfading into the next before it ends
+struct _Playlist {
+  char paths[AUDIO_PLAYLIST_MAX][AUDIO_PATH_MAX];
+  int count, next, fade, failed;
+  unsigned int seq;
+};
+
+static unsigned int _nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned int)(ts.tv_sec*1000 + ts.tv_nsec/1000000);
+}
+
+static void _fade(_Music &m, float to, int ms) {
+  m.from = m.gain;
+  m.to = to;
+  m.fade = ms;
+  m.fadeTime = 0;
+  if (ms <= 0)
+    m.gain = to;
+}
+
+static void _silence(_Music &m) {
+  m.stream.detach_source();
+  m.active = false;
+  m.primed = false;
+}
+
+static bool _load(_Music &m, const char* path, bool loop, unsigned int seq) {
+  _silence(m);
+  if (!m.stream.set_source(m.source) || !m.stream.load(path)) {
+    fprintf(stderr, "*** audio thread: cannot play %s: %s", path, m.stream.get_error());
+    m.stream.detach_source();
+    return false;
+  }
+  m.stream.set_loop(loop);
+  m.seq = seq;
+  m.played = 0;
+  m.length = (int)(m.stream.get_length()*1000);
+  return true;
+}
+
+// starts a loaded or primed slot, fading the current music out over ms
+static void _begin(_Music *music, int &current, int next, int ms) {
+  _Music &m = music[next];
+  if (next != current) {
+    if (ms > 0)
+      _fade(music[current], 0, ms);
+    else
+      _silence(music[current]);
+  }
+  m.active = true;
+  m.primed = false;
+  m.gain = ms > 0 ? 0 : 1;
+  _fade(m, 1, ms);
+  current = next;
+  m.stream.play();
+}
+
+static void _play(_Music *music, int &current, const char* path, bool loop, int ms, unsigned int seq) {
+  // the old music fades out on the other slot; one still fading from an
+  // earlier crossfade is cut, a track waiting to come next is dropped
+  for (int i=0; i<2; ++i)
+    if (music[i].primed)
+      _silence(music[i]);
+  int next = music[current].active ? 1-current : current;
+  if (!_load(music[next], path, loop, seq)) {
+    _ended_seq = seq;
+    return;
+  }
+  _begin(music, current, next, ms);
+}
+
+static void _queue(_Playlist &list, _Music *music, int &current, const _AudioCommand &c) {
+  if (c.first) {
+    list.count = list.failed = 0;
+    list.next = 1;
+    list.fade = c.ms;
+    list.seq = c.seq;
+    _play(music, current, c.path, false, c.ms, c.seq);
+  }
+  if (list.count < AUDIO_PLAYLIST_MAX)
+    strcpy(list.paths[list.count++], c.path);
+}
+
+// the next track is opened and its first buffers decoded as soon as the
+// other slot is free, so the change itself costs nothing
+static void _advance(_Playlist &list, _Music *music, int &current) {
+  _Music &m = music[current];
+  _Music &other = music[1-current];
+  if (list.count == 0 || (!m.active && !other.primed))
+    return;
+  if (!other.active && !other.primed) {
+    const char* path = list.paths[list.next % list.count];
+    if (!_load(other, path, false, list.seq) || !other.stream.prebuffer()) {
+      other.stream.detach_source();
+      list.next++;
+      // nothing in the list plays, give up
+      if (++list.failed >= list.count)
+	list.count = 0;
+      return;
+    }
+    other.stream.set_volume(0);
+    other.primed = true;
+    list.failed = 0;
+  }
+  // a track of unknown length changes when it runs out
+  if (other.primed && (!m.active || (m.length > 0 && m.length - m.played <= list.fade))) {
+    list.next++;
+    _begin(music, current, 1-current, list.fade);
+  }
+}
+
+static void _update(_Music &m, float volume, int ms, bool playlist, bool paused) {
+  if (!m.active)
+    return;
+  // a paused source isn't playing() either, it must not look finished;
+  // fades and the playlist clock wait for it too
+  if (paused) {
+    m.stream.update();
+    return;
+  }
+  m.played += ms;
+  m.stream.update();
+  unsigned int underruns = m.stream.get_underruns();
+  if (underruns != m.underruns) {
+    _underruns += underruns - m.underruns;
+    m.underruns = underruns;
+  }
+  if (m.fade > 0) {
+    m.fadeTime += ms;
+    float k = m.fadeTime >= m.fade ? 1 : (float)m.fadeTime / m.fade;
+    m.gain = m.from + (m.to - m.from)*k;
+    if (k >= 1)
+      m.fade = 0;
+  }
+  if (m.fade == 0 && m.gain <= 0) {
+    _silence(m);
+    return;
+  }
+  // done decoding and the queue has played out
+  if (!m.stream.playing()) {
+    if (!playlist)
+      _ended_seq = m.seq;
+    _silence(m);
+    return;
+  }
+  m.stream.set_volume(m.gain * volume);
+}
+
+// emyl's pause() flips its flag, the next update() pauses or resumes the source
+static void _pause(_Music *music, bool &paused, bool pause) {
+  if (paused == pause)
+    return;
+  paused = pause;
+  for (int i=0; i<2; ++i)
+    if (music[i].active) {
+      music[i].stream.pause();
+      music[i].stream.update();
+    }
+}
+
+static void* _audioThread(void*) {
+  _Music *music = new _Music[2];
+  for (int i=0; i<2; ++i) {
+    alGenSources(1, &music[i].source);
+    music[i].active = music[i].primed = false;
+    music[i].gain = music[i].from = music[i].to = 0;
+    music[i].fade = music[i].fadeTime = 0;
+    music[i].seq = 0;
+    music[i].underruns = 0;
+  }
+  _Playlist list;
+  list.count = 0;
+  int current = 0;
+  float volume = _volume;
+  bool quit = false, paused = false;
+  unsigned int last = _nowMs();
+  while (!quit) {
+    while (_tail != _head) {
+      __sync_synchronize(); // the command is read after the head that published it
+      const _AudioCommand &c = _commands[_tail % AUDIO_COMMANDS];
+      switch (c.type) {
+      case _CMD_PLAY:
+	_pause(music, paused, false);
+	list.count = 0;
+	_play(music, current, c.path, c.loop, c.ms, c.seq);
+	break;
+      case _CMD_QUEUE:
+	_pause(music, paused, false);
+	_queue(list, music, current, c);
+	break;
+      case _CMD_STOP:
+	_pause(music, paused, false);
+	list.count = 0;
+	for (int i=0; i<2; ++i)
+	  if (c.ms > 0 && music[i].active)
+	    _fade(music[i], 0, c.ms);
+	  else
+	    _silence(music[i]);
+	break;
+      case _CMD_PAUSE:
+      case _CMD_RESUME:
+	_pause(music, paused, c.type == _CMD_PAUSE);
+	break;
+      case _CMD_VOLUME:
+	volume = c.volume;
+	break;
+      case _CMD_QUIT:
+	quit = true;
+	break;
+      }
+      __sync_synchronize(); // done with the slot before handing it back
+      _tail++;
+    }
+
+    unsigned int now = _nowMs();
+    int ms = (int)(now - last);
+    last = now;
+    if (!paused)
+      _advance(list, music, current);
+    for (int i=0; i<2; ++i)
+      _update(music[i], volume, ms, list.count > 0, paused);
+    if (!quit)
+      usleep(AUDIO_PERIOD_MS*1000);
+  }
+
+  for (int i=0; i<2; ++i) {
+    _silence(music[i]);
+    alDeleteSources(1, &music[i].source);
+  }
+  delete[] music;
+  return NULL;
+}
+
+// ----- game thread -----
+
+static void _closeContext() {
+  if (!_context)
+    return;
+  alcMakeContextCurrent(NULL);
+  alcDestroyContext(_context);
+  alcCloseDevice(_device);
+  _context = NULL;
+  _device = NULL;
+}
+
+static bool _start() {
+  if (_running)
+    return true;
+  if (!alcGetCurrentContext()) {
+    _device = alcOpenDevice(NULL);
+    _context = _device ? alcCreateContext(_device, NULL) : NULL;
+    if (!_context || !alcMakeContextCurrent(_context)) {
+      fprintf(stderr, "*** audio thread: no OpenAL device for the music.\n");
+      if (_context)
+	alcDestroyContext(_context);
+      if (_device)
+	alcCloseDevice(_device);
+      _context = NULL;
+      _device = NULL;
+      return false;
+    }
+  }
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, AUDIO_STACK_SIZE);
+  int ret = pthread_create(&_thread, &attr, _audioThread, NULL);
+  pthread_attr_destroy(&attr);
+  if (ret != 0) {
+    fprintf(stderr, "*** audio thread: cannot start (%d).\n", ret);
+    _closeContext();
+    return false;
+  }
+  printf("** Audio thread started.\n");
+  _running = true;
+  _paused = false;
+  return true;
+}
+
+static bool _post(const _AudioCommand &c) {
+  if (!_start())
+    return false;
+  if (_head - _tail >= AUDIO_COMMANDS) {
+    fprintf(stderr, "*** audio thread: command queue full, dropped a command.\n");
+    return false;
+  }
+  _commands[_head % AUDIO_COMMANDS] = c;
+  __sync_synchronize(); // the command is written before the head publishes it
+  _head++;
+  return true;
+}
+
+static _AudioCommand _command(int type) {
+  _AudioCommand c;
+  memset(&c, 0, sizeof(c));
+  c.type = type;
+  return c;
+}
+
+// starting, queueing or stopping music resumes it on the thread as well
+bool audioThreadCrossfade(const char* path, bool loop, int ms) {
+  if (strlen(path) >= AUDIO_PATH_MAX) {
+    fprintf(stderr, "*** audio thread: path too long: %s\n", path);
+    return false;
+  }
+  _AudioCommand c = _command(_CMD_PLAY);
+  strcpy(c.path, path);
+  c.loop = loop;
+  c.ms = ms;
+  c.seq = _play_seq + 1;
+  if (!_post(c))
+    return false;
+  _play_seq = c.seq;
+  _paused = false;
+  return true;
+}
+
+bool audioThreadPlaylist(const char** paths, int count, int ms) {
+  if (count <= 0 || count > AUDIO_PLAYLIST_MAX) {
+    fprintf(stderr, "*** audio thread: playlist of %d tracks (at most %d).\n", count, AUDIO_PLAYLIST_MAX);
+    return false;
+  }
+  for (int i=0; i<count; ++i)
+    if (strlen(paths[i]) >= AUDIO_PATH_MAX) {
+      fprintf(stderr, "*** audio thread: path too long: %s\n", paths[i]);
+      return false;
+    }
+  // all of it or nothing, so the thread never sees half a list
+  while (_running && AUDIO_COMMANDS - (_head - _tail) < (unsigned int)count)
+    usleep(AUDIO_PERIOD_MS*1000);
+  unsigned int seq = _play_seq + 1;
+  for (int i=0; i<count; ++i) {
+    _AudioCommand c = _command(_CMD_QUEUE);
+    strcpy(c.path, paths[i]);
+    c.first = i == 0;
+    c.ms = ms;
+    c.seq = seq;
+    if (!_post(c))
+      return false;
+  }
+  _play_seq = seq;
+  _paused = false;
+  return true;
+}
+
+bool audioThreadPlay(const char* path, bool loop) {
+  return audioThreadCrossfade(path, loop, 0);
+}
+
+bool audioThreadStop(int ms) {
+  if (!_running)
+    return true;
+  _AudioCommand c = _command(_CMD_STOP);
+  c.ms = ms;
+  if (!_post(c))
+    return false;
+  _stop_seq = _play_seq;
+  _paused = false;
+  return true;
+}
+
+bool audioThreadPause(bool pause) {
+  if (!_running || !audioThreadIsPlaying())
+    return false;
+  if (pause == _paused)
+    return true;
+  if (!_post(_command(pause ? _CMD_PAUSE : _CMD_RESUME)))
+    return false;
+  _paused = pause;
+  return true;
+}
+
+bool audioThreadSetVolume(float volume) {
+  _volume = volume < 0 ? 0 : (volume > 1 ? 1 : volume);
+  if (!_running)
+    return true;
+  _AudioCommand c = _command(_CMD_VOLUME);
+  c.volume = _volume;
+  return _post(c);
+}
+
+bool audioThreadIsPlaying() {
+  return _play_seq != _stop_seq && _play_seq != _ended_seq;
+}
+
+bool audioThreadIsPaused() {
+  return _paused && audioThreadIsPlaying();
+}
+
+void audioThreadShutdown() {
+  if (!_running)
+    return;
+  // wait for room rather than lose the quit
+  while (_head - _tail >= AUDIO_COMMANDS)
+    usleep(AUDIO_PERIOD_MS*1000);
+  _post(_command(_CMD_QUIT));
+  pthread_join(_thread, NULL);
+  _running = false;
+  _paused = false;
+  _closeContext();
+  if (_underruns)
+    printf("** Audio thread: %u music underruns.\n", _underruns);
+}
+
+unsigned int audioThreadUnderruns() {
+  return _underruns;
+}
@@ -0,0 +1,35 @@
+#ifndef AUDIO_THREAD_H
+#define AUDIO_THREAD_H
+
+// Music streaming on a thread of its own.
+//
+// The game thread never touches the music streams: it posts commands to a
+// single producer / single consumer ring and returns. The audio thread
+// decodes the ogg files (emyl::stream), keeps the OpenAL queues full and
+// runs the crossfades, so a slow frame can't starve the music and a slow
+// decode can't stall a frame.
+//
+// All functions but audioThreadUnderruns are for the game thread only.
+
+// the thread starts with the first command, on the game's AL context or,
+// where there is none, on one of its own
+bool audioThreadPlay(const char* path, bool loop);
+bool audioThreadCrossfade(const char* path, bool loop, int ms);
+// up to 8 tracks in turn, round and round; the next one is decoded ahead
+// and crossfades in over ms before the current one ends
+bool audioThreadPlaylist(const char** paths, int count, int ms);
+bool audioThreadStop(int ms = 0);
+// holds the music where it is, fades and playlist changes included;
+// false when nothing plays
+bool audioThreadPause(bool pause);
+bool audioThreadSetVolume(float volume);
+bool audioThreadIsPlaying(); // paused or not
+bool audioThreadIsPaused();
+// stops the music, joins the thread and closes its context; the next
+// command starts it again
+void audioThreadShutdown();
+
+// times the music ran out of queued buffers since start
+unsigned int audioThreadUnderruns();
+
+#endif // AUDIO_THREAD_H
@@ -609,6 +609,7 @@ bool stream::load_generic(void *sndfile, ov_callbacks *ptr_callbacks)
 	if(m_uiFlags & STREAM_OGG_LOADED) ov_clear(&m_ogg);
 	memcpy(&m_ogg, &vf, sizeof(OggVorbis_File));
 	m_uiFlags |= STREAM_OGG_LOADED;
+	m_uiFlags &= ~STREAM_OGG_PRIMED;
 
 	return true;
 }
@@ -663,6 +664,46 @@ void stream::free_source()
 
 /*---------------------------------------------------------------------------*/
 
+void stream::detach_source()
+{
+	stop();
+
+	if (m_uiSource)
+	{
+		alSourceStop(m_uiSource);
+		alSourcei(m_uiSource, AL_BUFFER, 0);
+		m_uiSource = 0;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool stream::prebuffer()
+{
+	if (!m_uiSource) return false;
+
+	if((m_uiFlags & STREAM_OGG_PLAYING) ||
+	  !(m_uiFlags & STREAM_OGG_LOADED))
+		return false;
+
+	alSourceStop(m_uiSource);
+
+	ALint queued; ALuint buffer;
+	alGetSourcei(m_uiSource, AL_BUFFERS_QUEUED, &queued);
+	while(queued--) alSourceUnqueueBuffers(m_uiSource, 1, &buffer);
+
+	for( int i = 0; i < NUM_BUFFERS; i++)
+	{
+		if(!bStream(m_vbuffers[i])) break;
+		alSourceQueueBuffers (m_uiSource, 1, m_vbuffers+i);
+	}
+
+	m_uiFlags |= STREAM_OGG_PRIMED;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void stream::play()
 {
 	if (!m_uiSource) return;	
@@ -675,6 +716,16 @@ void stream::play()
 	}
 
 	m_uiFlags &= ~STREAM_OGG_PAUSE;
+
+	// already queued by prebuffer()
+	if(m_uiFlags & STREAM_OGG_PRIMED)
+	{
+		m_uiFlags &= ~STREAM_OGG_PRIMED;
+		alSourcePlay (m_uiSource);
+		s_instances.insert(this);
+		m_uiFlags |= STREAM_OGG_PLAYING;
+		return;
+	}
 	
 	alSourceStop(m_uiSource);
 	
@@ -701,6 +752,7 @@ void stream::play()
 /*---------------------------------------------------------------------------*/
 void stream::stop()
 {
+	m_uiFlags &= ~STREAM_OGG_PRIMED;
 	if(m_uiFlags&STREAM_OGG_PLAYING)
 	{
 		m_uiFlags &= ~(STREAM_OGG_PLAYING|STREAM_OGG_PAUSE);
@@ -745,6 +797,9 @@ void stream::update()
 	}
 	else
 	{
+		// a stopped source that is still meant to play used up every
+		// queued buffer before we refilled it
+		if(state == AL_STOPPED) m_uiUnderruns++;
 		if(state != AL_PLAYING) alSourcePlay (m_uiSource);
 	}
 	
@@ -815,6 +870,14 @@ bool stream::playing()
 
 /*---------------------------------------------------------------------------*/
 
+double stream::get_length()
+{
+	if(!(m_uiFlags & STREAM_OGG_LOADED)) return 0;
+	return ov_time_total(&m_ogg, -1);
+}
+
+/*---------------------------------------------------------------------------*/
+
 void stream::set_volume(ALfloat _volume)
 {
 	if(_volume > 1.0f && _volume < 0.0f) return;
@@ -871,7 +934,7 @@ bool stream::bStream(ALuint _buff)
 
 /*---------------------------------------------------------------------------*/
 
-inline char *stream::get_error() {return m_sLastError;}
+char *stream::get_error() {return m_sLastError;}
 
 /*---------------------------------------------------------------------------*/
 
@@ -48,6 +48,7 @@ SOFTWARE.
 #define STREAM_OGG_PLAYING (1<<2)
 #define STREAM_OGG_PAUSE   (1<<3)
 #define STREAM_OGG_LOOP    (1<<4)
+#define STREAM_OGG_PRIMED  (1<<5)
 
 namespace emyl {
 
@@ -65,20 +66,26 @@ public:
 	bool   set_source(ALuint _source);
 	ALuint get_source() {return m_uiSource;}
 	void   free_source();
+	void   detach_source(); // for sources not from the manager
 
 	void   update();
+	bool   prebuffer(); // decode the head now, so play() starts at once
 	void   play();
 	void   pause() {m_uiFlags ^= STREAM_OGG_PAUSE;}
 	void   stop();
 	
 	void   seek(double _secs);
 	bool   playing();
+	double get_length(); // seconds
 
 	void   set_loop(bool _loop);
 	void   set_volume(ALfloat _volume);
 
 	char*  get_error();
 
+	// times the source ran dry and had to be restarted
+	unsigned int get_underruns() {return m_uiUnderruns;}
+
 	static void updateAll();
 
 private:
@@ -95,6 +102,7 @@ private:
 	ALuint           m_vbuffers[NUM_BUFFERS];
 	unsigned int     m_uiFlags;
 	ALuint           m_uiSource;
+	unsigned int     m_uiUnderruns;
 
 	char*            m_sLastError;
 };
@@ -25,6 +25,8 @@
 #include "dgreed/utils.h"
 #include "dgreed/darray.h"
 #include "dgreed/memory.h"
+#include "audio_thread.h"
+#include "soft_mixer.h"
 
 # include <AL/al.h>
 
@@ -247,10 +249,261 @@ static s3eBool done = S3E_FALSE;
 static Uint8* keys = NULL;
 // end.
 
+/// Headless backend (SK_HEADLESS=1): no window, no GL context.
+static bool _headless = false;
+
+/// Input record/replay (SK_RECORD=file, SK_REPLAY=file).
+/// The log holds every reading the game takes, in order: timer values,
+/// the pointer events seen by each s3ePointerUpdate and key states.
+/// Replay hands back the same readings, so the session runs again on
+/// a virtual clock and as fast as it can be drawn.
+enum {
+  _REC_TIMER = 0, // + varint delta from the previous timer reading
+  _REC_UPDATE,    // closes the events of one s3ePointerUpdate
+  _REC_UP,        // + int16 x, y
+  _REC_DOWN,      // + int16 x, y
+  _REC_MOVE,      // + int16 x, y
+  _REC_KEY,       // + uint8 state
+};
+static const char _rec_magic[4] = { 'S', 'K', 'I', '1' };
+static FILE *_rec_file = NULL;
+static bool _recording = false, _replaying = false;
+static uint32 _rec_clock = 0;   // last timer reading
+static uint32 _rec_count = 0;   // records read or written
+static uint32 _rec_started = 0; // real time of the start, for the report
+
+static void _recOpen() {
+  const char *path;
+  if ((path = getenv("SK_REPLAY")) != NULL) {
+    char magic[4];
+    _rec_file = fopen(path, "rb");
+    if (_rec_file == NULL || fread(magic, 4, 1, _rec_file) != 1 || memcmp(magic, _rec_magic, 4)) {
+      fprintf(stderr, "*** Cannot replay %s, not an input log.\n", path);
+      if (_rec_file) fclose(_rec_file);
+      _rec_file = NULL;
+      return;
+    }
+    _replaying = true;
+  } else if ((path = getenv("SK_RECORD")) != NULL) {
+    _rec_file = fopen(path, "wb");
+    if (_rec_file == NULL) {
+      fprintf(stderr, "*** Cannot record input to %s.\n", path);
+      return;
+    }
+    fwrite(_rec_magic, 4, 1, _rec_file);
+    _recording = true;
+  } else
+    return;
+  printf("** %s input %s %s.\n", _replaying?"Replaying":"Recording", _replaying?"from":"to", path);
+  _rec_started = SDL_GetTicks();
+}
+
+static void _recClose() {
+  if (_rec_file == NULL)
+    return;
+  printf("** Input log: %u records, %u ms virtual, %u ms real.\n", _rec_count, _rec_clock, SDL_GetTicks() - _rec_started);
+  fclose(_rec_file);
+  _rec_file = NULL;
+  _recording = _replaying = false;
+}
+
+static void _recPut(uint8 type) {
+  fputc(type, _rec_file);
+  _rec_count++;
+}
+
+static void _recPutVarint(uint32 v) {
+  while(v >= 0x80) {
+    fputc((v & 0x7f) | 0x80, _rec_file);
+    v >>= 7;
+  }
+  fputc(v, _rec_file);
+}
+
+static void _recPutPoint(int x, int y) {
+  int16 p[2] = { (int16)x, (int16)y };
+  fwrite(p, sizeof(p), 1, _rec_file);
+}
+
+// the log ran out or no longer matches what the game asks for: stop the run
+static void _recEnd(bool diverged) {
+  if (diverged)
+    fprintf(stderr, "*** Replay diverged at record %u.\n", _rec_count);
+  _recClose();
+  done = S3E_TRUE;
+}
+
+// next record, or -1 when the log is over
+static int _recGet() {
+  const int type = fgetc(_rec_file);
+  if (type == EOF) {
+    _recEnd(false);
+    return -1;
+  }
+  _rec_count++;
+  return type;
+}
+
+static uint32 _recGetVarint() {
+  uint32 v = 0;
+  int shift = 0, c;
+  do {
+    c = fgetc(_rec_file);
+    v |= (uint32)(c & 0x7f) << shift;
+    shift += 7;
+  } while(c != EOF && (c & 0x80));
+  return v;
+}
+
+static void _recGetPoint(int &x, int &y) {
+  int16 p[2] = { 0, 0 };
+  fread(p, sizeof(p), 1, _rec_file);
+  x = p[0]; y = p[1];
+}
+
+uint32 s3eTimerGetMs() {
+  if (_replaying) {
+    const int type = _recGet();
+    if (type == _REC_TIMER)
+      _rec_clock += _recGetVarint();
+    else if (type != -1)
+      _recEnd(true);
+    return _rec_clock;
+  }
+  const uint32 now = SDL_GetTicks();
+  if (_recording) {
+    _recPut(_REC_TIMER);
+    _recPutVarint(now - _rec_clock);
+    _rec_clock = now;
+  }
+  return now;
+}
+
+static void _pumpNullSink();
+
+void s3eDeviceYield(int ms) {
+  _pumpNullSink();
+  if (ms > 0 && !_replaying) SDL_Delay(ms);
+}
+
+/// Scripted input (SK_SCRIPT=file), one event per line:
+///   <ms> down|up|move <x> <y>
+///   <ms> quit
+/// with times counted from Iw2DInit.
+struct _ScriptEvent {
+  uint32 at;
+  int type; // 0 up, 1 down, 2 move, 3 quit
+  int x, y;
+};
+static vector<_ScriptEvent> _script;
+static size_t _script_next = 0;
+static uint32 _script_start = 0;
+
+static void _loadScript(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "*** Input script %s not found.\n", path);
+    return;
+  }
+  char line[256], cmd[16];
+  int n = 0;
+  while(fgets(line, sizeof(line), f)) {
+    ++n;
+    if (line[0] == '#' || line[0] == '\n') continue;
+    _ScriptEvent ev = { 0, 0, 0, 0 };
+    if (sscanf(line, "%u %15s %d %d", &ev.at, cmd, &ev.x, &ev.y) < 2) {
+      fprintf(stderr, "*** %s:%d: cannot parse input event.\n", path, n);
+      continue;
+    }
+    if (!strcmp(cmd, "up")) ev.type = 0;
+    else if (!strcmp(cmd, "down")) ev.type = 1;
+    else if (!strcmp(cmd, "move")) ev.type = 2;
+    else if (!strcmp(cmd, "quit")) ev.type = 3;
+    else {
+      fprintf(stderr, "*** %s:%d: unknown input event %s.\n", path, n, cmd);
+      continue;
+    }
+    _script.push_back(ev);
+  }
+  fclose(f);
+  printf("** Input script %s: %d events.\n", path, (int)_script.size());
+}
+
+static void _pointerButton(int x, int y, uint32 pressed) {
+  if (_recording) {
+    _recPut(pressed?_REC_DOWN:_REC_UP);
+    _recPutPoint(x, y);
+  }
+  if (_ptrButtonEvent.fn) {
+    s3ePointerEvent ev = { S3E_POINTER_BUTTON_LEFTMOUSE, pressed, x, y };
+    _ptrButtonEvent.fn( &ev, _ptrButtonEvent.userData);
+  }
+}
+
+static void _pointerMotion(int x, int y) {
+  if (_recording) {
+    _recPut(_REC_MOVE);
+    _recPutPoint(x, y);
+  }
+  if (_ptrTouchMotionEvent.fn) {
+    s3ePointerMotionEvent ev = { x, y };
+    _ptrTouchMotionEvent.fn( &ev, _ptrTouchMotionEvent.userData);
+  }
+}
+
+// deliver every scripted event that is due
+static bool _scriptPump() {
+  bool any = false;
+  const uint32 now = SDL_GetTicks() - _script_start;
+  while(_script_next < _script.size() && _script[_script_next].at <= now) {
+    const _ScriptEvent &ev = _script[_script_next++];
+    switch(ev.type) {
+    case 0: case 1: _pointerButton(ev.x, ev.y, ev.type); break;
+    case 2: _pointerMotion(ev.x, ev.y); break;
+    case 3: done = S3E_TRUE; break;
+    }
+    any = true;
+  }
+  return any;
+}
+
+// deliver the events recorded for one s3ePointerUpdate
+static void _replayPointer() {
+  int x, y;
+  for(;;) {
+    const int type = _recGet();
+    switch(type) {
+    case _REC_UP: case _REC_DOWN:
+      _recGetPoint(x, y);
+      _pointerButton(x, y, type == _REC_DOWN);
+      break;
+    case _REC_MOVE:
+      _recGetPoint(x, y);
+      _pointerMotion(x, y);
+      break;
+    case _REC_UPDATE: case -1:
+      return;
+    default:
+      _recEnd(true);
+      return;
+    }
+  }
+}
+
 s3eResult s3ePointerUpdate()
 {
   SDL_Event event = { 0 };
-  if (SDL_PollEvent(&event))
+  if (_replaying) {
+    _replayPointer();
+    // live input is ignored, only a close request gets through
+    while(!_headless && SDL_PollEvent(&event))
+      if (event.type == SDL_QUIT)
+	done = S3E_TRUE;
+    return S3E_RESULT_SUCCESS;
+  }
+
+  _scriptPump();
+  if (!_headless && SDL_PollEvent(&event))
     switch(event.type) {
     case SDL_QUIT:
       {
@@ -258,29 +511,42 @@ s3eResult s3ePointerUpdate()
       }; break;
     case SDL_MOUSEBUTTONDOWN:
       {
-	const int x = event.button.x, y = event.button.y;
-	if (_ptrButtonEvent.fn) {
-	  s3ePointerEvent ev = { S3E_POINTER_BUTTON_LEFTMOUSE, 1, x, y };
-	  _ptrButtonEvent.fn( &ev, _ptrButtonEvent.userData);
-	}
+	_pointerButton(event.button.x, event.button.y, 1);
       }; break;
     case SDL_MOUSEBUTTONUP:
       {
-	const int x = event.button.x, y = event.button.y;
-	if (_ptrButtonEvent.fn) {
-	  s3ePointerEvent ev = { S3E_POINTER_BUTTON_LEFTMOUSE, 0, x, y };
-	  _ptrButtonEvent.fn( &ev, _ptrButtonEvent.userData);
-	}
+	_pointerButton(event.button.x, event.button.y, 0);
       }; break;
     case SDL_MOUSEMOTION: 
       {
-	const int x = event.button.x, y = event.button.y;
-	if (_ptrTouchMotionEvent.fn) {
-	  s3ePointerMotionEvent ev = { x, y };
-	  _ptrTouchMotionEvent.fn( &ev, _ptrTouchMotionEvent.userData);
-	}
+	_pointerMotion(event.button.x, event.button.y);
       }; break;
     }
+  if (_recording)
+    _recPut(_REC_UPDATE);
+  return S3E_RESULT_SUCCESS;
+}
+
+// sleep up to ms, waking up as soon as there is input waiting
+void s3eDeviceYieldUntilEvent(int ms)
+{
+  if (_replaying)
+    return;
+  const uint32 until = SDL_GetTicks() + ms;
+  SDL_Event event;
+  for(;;) {
+    if (_script_next < _script.size() && _script[_script_next].at <= SDL_GetTicks() - _script_start)
+      return;
+    if (!_headless) {
+      SDL_PumpEvents();
+      if (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) > 0)
+        return;
+    }
+    const int32 left = until - SDL_GetTicks();
+    if (left <= 0)
+      return;
+    SDL_Delay(left < 10 ? left : 10);
+  }
 }
 
 const int s3eKeyCount = 211;
@@ -408,7 +674,22 @@ static SDLKey s_s3eToSDLTranslation[s3eKeyCount] =
 };
 
 void s3eKeyboardUpdate() { keys = SDL_GetKeyState(NULL); }
-s3eEnum s3eKeyboardGetState(s3eKeys key) { keys[s_s3eToSDLTranslation[key]]?S3E_KEY_STATE_PRESSED:S3E_KEY_STATE_RELEASED; }
+s3eEnum s3eKeyboardGetState(s3eKeys key) {
+  if (_replaying) {
+    const int type = _recGet();
+    if (type == _REC_KEY)
+      return (s3eEnum)fgetc(_rec_file);
+    if (type != -1)
+      _recEnd(true);
+    return S3E_KEY_STATE_RELEASED;
+  }
+  const s3eEnum state = (keys && keys[s_s3eToSDLTranslation[key]])?S3E_KEY_STATE_PRESSED:S3E_KEY_STATE_RELEASED;
+  if (_recording) {
+    _recPut(_REC_KEY);
+    fputc(state, _rec_file);
+  }
+  return state;
+}
 s3eBool s3eDeviceCheckQuitRequest() { return done; }
 
 s3eFile* s3eFileOpen(const char* filename, const char* mode) { 
@@ -469,101 +750,504 @@ s3eBool s3eAudioIsCodecSupported(s3eEnum codec) {
 static uint _default_freq = 44100;
 static string _audio_error;
 
-s3eResult s3eAudioPlay(const char* filename, uint32 repeatCount) { 
+// sound effects play on OpenAL or the software mixer, SK_SOUND picks:
+// "openal", "mixer" (out through SDL) or "null" (mixed, never heard).
+// Only QNX sets up an AL context, everywhere else the mixer is the default.
+enum { _SOUND_OPENAL, _SOUND_MIXER, _SOUND_NULL };
+static int _sound_backend = -1;
+
+static int _soundBackend() {
+  if (_sound_backend >= 0)
+    return _sound_backend;
+  const char *env = getenv("SK_SOUND");
+#if defined __QNXNTO__
+  _sound_backend = _SOUND_OPENAL;
+#else
+  _sound_backend = _SOUND_MIXER;
+#endif
+  if (env && strcmp(env, "openal") == 0)
+    _sound_backend = _SOUND_OPENAL;
+  else if (env && strcmp(env, "mixer") == 0)
+    _sound_backend = _SOUND_MIXER;
+  else if (env && strcmp(env, "null") == 0)
+    _sound_backend = _SOUND_NULL;
+  else if (env)
+    fprintf (stderr, "*** Unknown SK_SOUND=%s, using %s.\n", env, _sound_backend == _SOUND_OPENAL ? "openal" : "mixer");
+  if (_sound_backend != _SOUND_OPENAL && !softMixerInit(_default_freq, _sound_backend == _SOUND_NULL)) {
+    fprintf (stderr, "*** Software mixer unavailable, sound effects on OpenAL.\n");
+    _sound_backend = _SOUND_OPENAL;
+  }
+  return _sound_backend;
+}
+
+static bool _mixed() { return _soundBackend() != _SOUND_OPENAL; }
+
+// nothing pulls from the null sink, so every yield mixes what the time
+// since the last one would have played
+static uint32 _null_sink_clock = 0;
+
+static void _pumpNullSink() {
+  if (_sound_backend != _SOUND_NULL)
+    return;
+  static int16 out[4096];
+  const uint32 now = SDL_GetTicks();
+  uint32 ms = _null_sink_clock ? now - _null_sink_clock : 0;
+  _null_sink_clock = now;
+  if (ms > 1000)
+    ms = 1000;
+  for (int frames = (int)((uint64)ms * _default_freq / 1000); frames > 0; frames -= 4096)
+    softMixerRender(out, frames < 4096 ? frames : 4096);
+}
+
+// music: an ogg next to the requested file streams on the audio thread,
+// anything else goes to the platform player. The data has the mp3s the
+// Marmalade build plays, make_ogg.sh in there makes the oggs from them.
+static bool _music_streamed = false;
+
+static void _streamMusic() {
+  if (!_music_streamed)
+    s3eAudioStop();
+  _music_streamed = true;
+#if defined __QNXNTO__
+  // alut's context, the thread would open a second one without it
+  _audio;
+#endif
+}
+
+static string _streamedMusic(const char* filename) {
+  string ogg = filename;
+  size_t dot = ogg.rfind('.');
+  if (dot != string::npos)
+    ogg.erase(dot);
+  ogg += ".ogg";
+  return resourceExists(ogg.c_str()) ? resourcePath(ogg.c_str()) : "";
+}
+
+s3eResult s3eAudioCrossfade(const char* filename, uint32 repeatCount, int32 ms) {
+  string ogg = _streamedMusic(filename);
+  if (!ogg.empty()) {
+    _streamMusic();
+    // repeat 0 loops forever
+    return audioThreadCrossfade(ogg.c_str(), repeatCount == 0, ms) ? S3E_RESULT_SUCCESS : S3E_RESULT_ERROR;
+  }
+  if (_music_streamed)
+    audioThreadStop();
+  _music_streamed = false;
+#if defined __QNXNTO__
   if (_audio->playBackgroundMusic(filename, repeatCount))
     return S3E_RESULT_SUCCESS; 
-  else
-    return S3E_RESULT_ERROR; 
+#else
+  fprintf(stderr, "*** No player for %s, convert it to ogg (make_ogg.sh in the data).\n", filename);
+#endif
+  return S3E_RESULT_ERROR; 
+}
+s3eResult s3eAudioPlaylist(const char** filenames, int count, int32 ms) {
+  if (count <= 0)
+    return S3E_RESULT_ERROR;
+  // the tracks without an ogg are left out rather than the whole list
+  vector<string> oggs;
+  for (int i=0; i<count; ++i) {
+    string ogg = _streamedMusic(filenames[i]);
+    if (!ogg.empty())
+      oggs.push_back(ogg);
+    else
+      fprintf(stderr, "*** No ogg for %s, left out of the playlist.\n", filenames[i]);
+  }
+  // only streamed music can follow on, the platform player loops the first
+  if (oggs.empty())
+    return s3eAudioCrossfade(filenames[0], 0, ms);
+  vector<const char*> paths;
+  for (size_t i=0; i<oggs.size(); ++i)
+    paths.push_back(oggs[i].c_str());
+  _streamMusic();
+  return audioThreadPlaylist(&paths[0], (int)paths.size(), ms) ? S3E_RESULT_SUCCESS : S3E_RESULT_ERROR;
+}
+s3eResult s3eAudioPlay(const char* filename, uint32 repeatCount) { 
+  return s3eAudioCrossfade(filename, repeatCount, 0);
+}
+s3eResult s3eAudioPause() {
+  if (_music_streamed)
+    return audioThreadPause(true) ? S3E_RESULT_SUCCESS : S3E_RESULT_ERROR;
+#if defined __QNXNTO__
+  return _audio->pauseBackgroundMusic()?S3E_RESULT_SUCCESS:S3E_RESULT_ERROR;
+#else
+  return S3E_RESULT_ERROR;
+#endif
+}
+s3eResult s3eAudioResume() {
+  if (_music_streamed)
+    return audioThreadPause(false) ? S3E_RESULT_SUCCESS : S3E_RESULT_ERROR;
+#if defined __QNXNTO__
+  return _audio->resumeBackgroundMusic()?S3E_RESULT_SUCCESS:S3E_RESULT_ERROR;
+#else
+  return S3E_RESULT_ERROR;
+#endif
+}
+void s3eAudioStop() {
+  if (_music_streamed) {
+    audioThreadStop();
+    return;
+  }
+#if defined __QNXNTO__
+  _audio->stopBackgroundMusic();
+#endif
+}
+s3eBool s3eAudioIsPlaying() {
+  // paused music isn't playing, as on Marmalade
+  if (_music_streamed)
+    return audioThreadIsPlaying() && !audioThreadIsPaused() ? S3E_TRUE : S3E_FALSE;
+#if defined __QNXNTO__
+  return _audio->isBackgroundMusicPlaying()?S3E_RESULT_SUCCESS:S3E_RESULT_ERROR;
+#else
+  return S3E_FALSE;
+#endif
 }
-s3eResult s3eAudioPause() { return _audio->pauseBackgroundMusic()?S3E_RESULT_SUCCESS:S3E_RESULT_ERROR; }
-s3eResult s3eAudioResume(){ return _audio->resumeBackgroundMusic()?S3E_RESULT_SUCCESS:S3E_RESULT_ERROR; }
-void s3eAudioStop() { _audio->stopBackgroundMusic(); }
-s3eBool s3eAudioIsPlaying() { return _audio->isBackgroundMusicPlaying()?S3E_RESULT_SUCCESS:S3E_RESULT_ERROR; }
 void s3eAudioSetInt(s3eEnum f, int v) {
-  if (f == S3E_AUDIO_VOLUME) _audio->setEffectsVolume( clamp(v, 0, 255)/255. );
+  if (f != S3E_AUDIO_VOLUME)
+    return;
+  audioThreadSetVolume(clamp(v, 0, 255)/255.f);
+#if defined __QNXNTO__
+  _audio->setEffectsVolume( clamp(v, 0, 255)/255. );
+#endif
+}
+int32 s3eAudioGetInt(s3eEnum f) {
+  if (f == S3E_AUDIO_UNDERRUNS) return audioThreadUnderruns();
+  return 0;
 }
 
-// allocated sound information:
-typedef pair<ALuint, int16*> BufferInfo;
-typedef pair<ALuint, BufferInfo> ChannelInfo;
-static map<ALuint, BufferInfo> _channels;
-static vector<BufferInfo> _buffers;
-static vector<ALuint> _sources;
-// end.
+// sound bank: every sample is uploaded once to an AL buffer (or the
+// mixer) and played by handle; a slot with no buffer is free for the
+// next registration
+struct _SoundSample {
+  ALuint buffer; // or 1 + the mixer's sample
+  int16 *start; // only for samples s3eSoundChannelPlay registered
+  uint32 numSamples;
+  int priority;
+  int maxInstances; // 0 for no limit
+};
+static vector<_SoundSample> _samples;
+static map<int16*, int> _sample_handles; // for callers that only pass the pointer
+
+// voice pool: a fixed set of sources made once; whether a voice is busy
+// comes from when its sample ends, so picking one never asks AL
+#define SOUND_VOICES 16
+struct _Voice {
+  ALuint source;
+  int handle; // -1 when idle
+  int priority;
+  int volume;
+  bool loop;
+  uint32 started, ends;
+};
+static vector<_Voice> _voices;
+static s3eSoundBankStats _voice_stats;
+
+static void _initVoices() {
+  if (!_voices.empty())
+    return;
+  const bool mixed = _mixed();
+  __checkALError("_initVoices"); // clear error message
+  for (int v=0; v<SOUND_VOICES && v<SOFT_MIXER_VOICES; ++v) {
+    _Voice voice;
+    voice.source = 0;
+    if (!mixed)
+      alGenSources(1, &voice.source);
+    if (!mixed && __checkALError("_initVoices/alGenSources") != AL_NO_ERROR)
+      break; // fewer voices than asked for
+    voice.handle = -1;
+    voice.priority = 0;
+    voice.volume = 0;
+    voice.loop = false;
+    voice.started = voice.ends = 0;
+    _voices.push_back(voice);
+  }
+  if (_voices.size() < SOUND_VOICES)
+    fprintf (stderr, "*** sound: only %d of %d voices available.\n", (int)_voices.size(), SOUND_VOICES);
+}
 
-s3eResult s3eSoundChannelPlay(int channel, int16* start, uint32 numSamples, int32 repeat, int32 loopfrom) {
-  if (channel < 0) {
-    _audio_error = f_ssprintf("s3eSoundChannelPlay: invalid channel %d (of %d allocated).", channel, _channels.size());
-    fprintf (stderr, "*** %s\n", _audio_error.c_str());
-    return S3E_RESULT_ERROR;
-  } else {
+static bool _voiceBusy(const _Voice &voice, uint32 now) {
+  return voice.handle >= 0 && (voice.loop || (int32)(voice.ends - now) > 0);
+}
+
+static void _stopVoice(_Voice &voice) {
+  if (voice.handle < 0)
+    return;
+  if (_mixed())
+    softMixerStop(&voice - &_voices[0]);
+  else {
+    alSourceStop(voice.source);
+    alSourcei(voice.source, AL_BUFFER, 0);
+  }
+  voice.handle = -1;
+}
 
-    // look for this buffer:
-    int b = 0; for(int b=0; b<_buffers.size(); ++b) {
-      const BufferInfo &binfo = _buffers[b];
-      if (binfo.second == start)
-	break;
+// the voice a new sound goes to: past the sound's own instance limit its
+// oldest instance, else an idle voice, else the lowest priority one not
+// above the new sound, quietest and then oldest first; -1 drops the sound
+static int _pickVoice(int priority, int handle) {
+  _initVoices();
+  const uint32 now = SDL_GetTicks();
+  const int maxInstances = handle >= 0 ? _samples[handle].maxInstances : 0;
+  int instances = 0, oldestInstance = -1, idle = -1, steal = -1;
+  for (int v=0; v<_voices.size(); ++v) {
+    const _Voice &voice = _voices[v];
+    if (!_voiceBusy(voice, now)) {
+      if (idle < 0)
+	idle = v;
+      continue;
+    }
+    if (voice.handle == handle) {
+      instances++;
+      if (oldestInstance < 0 || (int32)(voice.started - _voices[oldestInstance].started) < 0)
+	oldestInstance = v;
+    }
+    if (voice.priority > priority)
+      continue;
+    if (steal < 0) {
+      steal = v;
+      continue;
     }
+    const _Voice &best = _voices[steal];
+    if (voice.priority != best.priority) {
+      if (voice.priority < best.priority)
+	steal = v;
+    } else if (voice.volume != best.volume) {
+      if (voice.volume < best.volume)
+	steal = v;
+    } else if ((int32)(voice.started - best.started) < 0)
+      steal = v;
+  }
+  if (maxInstances > 0 && instances >= maxInstances) {
+    _voice_stats.steals++;
+    return oldestInstance;
+  }
+  if (idle >= 0)
+    return idle;
+  if (steal >= 0)
+    _voice_stats.steals++;
+  else
+    _voice_stats.drops++;
+  return steal;
+}
 
-    BufferInfo binfo;
-    if (b == _buffers.size()) { // add new buffer
-      ALuint buffer;
-      alGenBuffers (1, &buffer);
-      if (__checkALError("s3eSoundChannelPlay/alGenBuffers") != AL_NO_ERROR) {
-	printf("*** adding new audio buffer %d.\n", buffer);
-	alBufferData(buffer, AL_FORMAT_STEREO16, start, numSamples, _default_freq);
-	_buffers.push_back(binfo = BufferInfo(buffer, start));
-      } else {
-	_audio_error = "s3eSoundChannelPlay: failed with alGenBuffers.";
-	fprintf (stderr, "*** %s\n", _audio_error.c_str());
-	return S3E_RESULT_ERROR;
-      }
+static bool _uploadSample(int16* start, uint32 numSamples, ALuint &buffer) {
+  __checkALError("s3eSoundBankRegister"); // clear error message
+  alGenBuffers(1, &buffer);
+  if (__checkALError("s3eSoundBankRegister/alGenBuffers") != AL_NO_ERROR) {
+    _audio_error = "s3eSoundBankRegister: failed with alGenBuffers.";
+    fprintf (stderr, "*** %s\n", _audio_error.c_str());
+    return false;
+  }
+  // raw sounds are 16 bit mono, the size is in bytes
+  alBufferData(buffer, AL_FORMAT_MONO16, start, numSamples*sizeof(int16), _default_freq);
+  if (__checkALError("s3eSoundBankRegister/alBufferData") != AL_NO_ERROR) {
+    alDeleteBuffers(1, &buffer);
+    _audio_error = "s3eSoundBankRegister: failed with alBufferData.";
+    fprintf (stderr, "*** %s\n", _audio_error.c_str());
+    return false;
+  }
+  return true;
+}
+
+int s3eSoundBankRegister(int16* start, uint32 numSamples, int priority, int maxInstances) {
+  ALuint buffer;
+  if (_mixed()) {
+    int mixed = softMixerAddSample(start, numSamples, _default_freq);
+    if (mixed < 0) {
+      _audio_error = "s3eSoundBankRegister: the mixer refused the sample.";
+      fprintf (stderr, "*** %s\n", _audio_error.c_str());
+      return -1;
     }
+    buffer = 1 + mixed;
+  } else if (!_uploadSample(start, numSamples, buffer))
+    return -1;
 
-    alSourcei(channel, AL_BUFFER, binfo.first);
-    alSourcei(channel, AL_LOOPING, repeat ? AL_TRUE : AL_FALSE);
-    alSourcePlay(channel);
+  int handle = 0;
+  while (handle < (int)_samples.size() && _samples[handle].buffer != 0)
+    handle++;
+  if (handle == (int)_samples.size())
+    _samples.push_back(_SoundSample());
+  _SoundSample &sample = _samples[handle];
+  sample.buffer = buffer;
+  sample.start = NULL;
+  sample.numSamples = numSamples;
+  sample.priority = priority;
+  sample.maxInstances = maxInstances;
+  return handle;
+}
 
-    _channels[channel] = binfo;
+void s3eSoundBankUnregister(int handle) {
+  if (handle < 0 || handle >= (int)_samples.size() || _samples[handle].buffer == 0)
+    return;
+  _SoundSample &sample = _samples[handle];
+  // a buffer still queued on a source can't be deleted
+  for (int v=0; v<_voices.size(); ++v)
+    if (_voices[v].handle == handle)
+      _stopVoice(_voices[v]);
+  if (_mixed())
+    softMixerRemoveSample(sample.buffer - 1);
+  else {
+    alDeleteBuffers(1, &sample.buffer);
+    __checkALError("s3eSoundBankUnregister/alDeleteBuffers");
+  }
+  if (sample.start != NULL)
+    _sample_handles.erase(sample.start);
+  sample.buffer = 0;
+  sample.start = NULL;
+  sample.numSamples = 0;
+}
 
-    return S3E_RESULT_SUCCESS;
+static s3eResult _playVoice(int channel, int handle, int32 repeat, int volume) {
+  if (channel < 0 || channel >= (int)_voices.size()) {
+    _audio_error = f_ssprintf("s3eSoundBankPlay: invalid channel %d (of %d allocated).", channel, (int)_voices.size());
+    fprintf (stderr, "*** %s\n", _audio_error.c_str());
+    return S3E_RESULT_ERROR;
+  }
+  if (handle < 0 || handle >= (int)_samples.size() || _samples[handle].buffer == 0) {
+    _audio_error = f_ssprintf("s3eSoundBankPlay: invalid sound %d.", handle);
+    fprintf (stderr, "*** %s\n", _audio_error.c_str());
+    return S3E_RESULT_ERROR;
+  }
+
+  const _SoundSample &sample = _samples[handle];
+  _Voice &voice = _voices[channel];
+  if (voice.handle >= 0 && !_mixed())
+    alSourceStop(voice.source);
+  voice.handle = handle;
+  voice.priority = sample.priority;
+  voice.volume = volume;
+  // repeat 0 plays forever, any other count plays once
+  voice.loop = repeat == 0;
+  voice.started = SDL_GetTicks();
+  voice.ends = voice.started + (uint32)((uint64)sample.numSamples * 1000 / _default_freq) + 1;
+  if (_mixed())
+    softMixerPlay(channel, sample.buffer - 1, voice.loop, volume);
+  else {
+    alSourcei(voice.source, AL_BUFFER, sample.buffer);
+    alSourcei(voice.source, AL_LOOPING, voice.loop ? AL_TRUE : AL_FALSE);
+    alSourcef(voice.source, AL_GAIN, volume / 256.f);
+    alSourcePlay(voice.source);
   }
+  _voice_stats.plays++;
+  return S3E_RESULT_SUCCESS;
+}
+
+int s3eSoundBankPlay(int handle, int32 repeat, int volume) {
+  if (handle < 0 || handle >= (int)_samples.size() || _samples[handle].buffer == 0) {
+    _audio_error = f_ssprintf("s3eSoundBankPlay: invalid sound %d.", handle);
+    fprintf (stderr, "*** %s\n", _audio_error.c_str());
+    return -1;
+  }
+  int channel = _pickVoice(_samples[handle].priority, handle);
+  if (channel < 0)
+    return -1; // everything playing matters more
+  if (_playVoice(channel, handle, repeat, volume) != S3E_RESULT_SUCCESS)
+    return -1;
+  return channel;
 }
-int s3eSoundGetFreeChannel() {
 
-  __checkALError("s3eSoundGetFreeChannel"); // clear error message
+void s3eSoundBankGetStats(s3eSoundBankStats* stats) {
+  *stats = _voice_stats;
+  _initVoices();
+  stats->voices = _voices.size();
+  stats->busy = 0;
+  const uint32 now = SDL_GetTicks();
+  for (int v=0; v<_voices.size(); ++v)
+    if (_voiceBusy(_voices[v], now))
+      stats->busy++;
+}
 
-  // look for free pre-allocated source:
-  for(int x=0; x<_sources.size(); ++x) {
-    ALint sourceState;
-    alGetSourcei(_sources[x], AL_SOURCE_STATE, &sourceState);
-    if (sourceState != AL_PLAYING) {
-      alSourcei(_sources[x], AL_BUFFER, 0);
-      return _sources[x];
-    }
+s3eResult s3eSoundChannelPlay(int channel, int16* start, uint32 numSamples, int32 repeat, int32 loopfrom) {
+  // the caller keeps its samples, so the pointer finds the upload again
+  int handle = -1;
+  map<int16*, int>::iterator it = _sample_handles.find(start);
+  if (it != _sample_handles.end()) {
+    if (_samples[it->second].numSamples == numSamples)
+      handle = it->second;
+    else
+      s3eSoundBankUnregister(it->second); // same memory, other sample
+  }
+  if (handle < 0) {
+    handle = s3eSoundBankRegister(start, numSamples);
+    if (handle < 0)
+      return S3E_RESULT_ERROR;
+    _samples[handle].start = start;
+    _sample_handles[start] = handle;
+  }
+  return _playVoice(channel, handle, repeat, 256);
+}
+
+// marmalade channels are the pool's voices, the sound isn't known yet so
+// only its own priority limits what can be taken
+int s3eSoundGetFreeChannel() {
+  int channel = _pickVoice(0, -1);
+  if (channel < 0) {
+    _audio_error = "s3eSoundGetFreeChannel: no voice available.";
+    fprintf (stderr, "*** %s\n", _audio_error.c_str());
   }
+  return channel;
+}
 
-  // create and add new source:
-  ALuint source;		
-  alGenSources(1, &source);
-  if (__checkALError("s3eSoundGetFreeChannel/alGenSources") != AL_NO_ERROR)
-    {
-      _sources.push_back(source);
-      return source;
-    }
-  
-  _audio_error = "s3eSoundGetFreeChannel: failed with alGenSources.";
-  fprintf (stderr, "*** %s\n", _audio_error.c_str());
-  return -1;
+void s3eSoundStopAllChannels() {
+  for (int v=0; v<_voices.size(); ++v)
+    _stopVoice(_voices[v]);
 }
 const char* s3eSoundGetErrorString() { return _audio_error.c_str(); }
 void s3eSoundSetInt(s3eEnum f, int v) {
-  if (f == S3E_SOUND_VOLUME) _audio->setBackgroundMusicVolume( clamp(v, 0, 255)/255. );
-  else if (f == S3E_SOUND_DEFAULT_FREQ) _default_freq = v;
+  if (f == S3E_SOUND_VOLUME) {
+    if (_mixed())
+      softMixerSetVolume(clamp(v, 0, 256));
+#if defined __QNXNTO__
+    _audio->setBackgroundMusicVolume( clamp(v, 0, 255)/255. );
+#endif
+  } else if (f == S3E_SOUND_DEFAULT_FREQ) _default_freq = v;
+}
+s3eResult s3eSoundMixerRender(int16* out, int frames) {
+  if (_soundBackend() != _SOUND_NULL)
+    return S3E_RESULT_ERROR;
+  softMixerRender(out, frames);
+  return S3E_RESULT_SUCCESS;
 }
 
 // -----  IwResManager -----
 
+static int _pot(int v) { int p = 1; while (p < v) p <<= 1; return p; }
+
+// what each texture file cost in video memory, kept after the image is
+// released, printed at exit with SK_TEXTURE_REPORT=1
+struct _TextureUse {
+  string format;
+  int width, height; // texels
+  size_t bytes;      // as uploaded
+  size_t before;     // the png padded to a power of two, as it used to be
+};
+static map<string, _TextureUse> _texture_use; // by file
+
+static void _useTexture(const string &file, const char *format, int width, int height, size_t bytes, size_t before) {
+  _TextureUse &use = _texture_use[file];
+  use.format = format; use.width = width; use.height = height;
+  use.bytes = bytes; use.before = before;
+}
+
+class CcIw2DFont;
+static void _release_font_strings(const CcIw2DFont *font);
+
+/// What the renderer has been asked to do. In headless mode this is all
+/// that happens: textures get placeholder names and draws are only counted.
+static Iw2DStats _stats = { 0, 0, 0, 0, 0, 0 };
+static uint _stats_texture = 0;
+static uint _fake_textures = 0;
+
+static uint _fakeTexture() { return ++_fake_textures; }
+
+static void _bindTexture(uint texture) {
+  if (texture != _stats_texture) {
+    _stats_texture = texture;
+    _stats.binds++;
+  }
+  if (!_headless) glBindTexture(GL_TEXTURE_2D, texture);
+}
+
 class CcIw2DFont : public CIw2DFont
 {
   int width, height, num;
@@ -571,9 +1255,10 @@ class CcIw2DFont : public CIw2DFont
   map<uint, uint16> utf8map;
   const CIwGxFont &descr;
   uint texture;
+  size_t bytes; // of the texture, which the copies share
   std::vector<TileCoord> regions;
 public:
-  CcIw2DFont(const CIwGxFont &font) : texture(0), num(0), descr(font)
+  CcIw2DFont(const CIwGxFont &font) : texture(0), bytes(0), num(0), descr(font)
   {
     string line = font.charmap;
     // process utf8 characters
@@ -618,13 +1303,20 @@ public:
     if (num != regions.size())
       fprintf(stderr, "CcIw2DFont image %s: diffrent number of regions and characters: %d<>%d.\n", font.image, regions.size(), num);
 
-    texture = SOIL_create_OGL_texture(idata, width, height, channels, SOIL_CREATE_NEW_ID, SOIL_FLAG_POWER_OF_TWO|SOIL_FLAG_MULTIPLY_ALPHA);
+    texture = _headless ? _fakeTexture() : SOIL_create_OGL_texture(idata, width, height, channels, SOIL_CREATE_NEW_ID, SOIL_FLAG_POWER_OF_TWO|SOIL_FLAG_MULTIPLY_ALPHA);
     free(idata);
+    bytes = (size_t)_pot(width)*_pot(height)*channels;
+    _useTexture(path, "font", _pot(width), _pot(height), bytes, bytes);
 
     printf("CcIw2DFont image %s: texture %d, dim. %dx%d\n", font.image, texture, width, height);
   }
 
+  virtual ~CcIw2DFont() {
+    _release_font_strings(this);
+  }
+
   uint GetTexture() const { return texture; }
+  size_t GetMemSize() const { return bytes; }
   //  not_found_ch : not found character placeholder
   const TileCoord &GetTextureRegion(uint ch, char not_found_ch = '?') {
     int index = 0; if (ch < 256)
@@ -690,20 +1382,216 @@ const CIwMat2D CIwMat2D::Identity;
 
 // ----- Iw2D -----
 
+static map<string, int> _live_images; // created images by resource name
+
+// ----- Precompressed textures -----
+
+// proj_compat/tools/texconv writes a .dds (S3TC) and, for opaque images,
+// a .pkm (ETC1) next to a png: premultiplied, padded to a power of two,
+// with the image size in the header. They go to the GL as they are when
+// it can sample them, otherwise the png is decoded like before.
+
+#define _DDS_SKEY 0x59454b53 // "SKEY", texconv's mark in dwReserved1
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+int query_DXT_capability(void); // SOIL.cpp
+
+int query_NPOT_capability(void); // SOIL.cpp
+
+static bool _dxt_textures = false, _etc1_textures = false, _npot_textures = false;
+
+static void _queryTextureFormats() {
+  _dxt_textures = query_DXT_capability() == 1; // SOIL_CAPABILITY_PRESENT
+  _npot_textures = query_NPOT_capability() == 1;
+  const char *ext = (const char*)glGetString(GL_EXTENSIONS);
+  _etc1_textures = ext && strstr(ext, "GL_OES_compressed_ETC1_RGB8_texture");
+  printf("** Compressed textures:%s%s\n", _dxt_textures?" S3TC":"", _etc1_textures?" ETC1":(_dxt_textures?"":" none"));
+  printf("** Non power of two textures: %s\n", _npot_textures?"yes":"no, trimming and padding");
+}
+
+// the file to upload instead of a png, empty if there is none usable;
+// only looks at the disk, so the preload workers can ask too
+static string _compressedPath(const string &png) {
+  string base = png.substr(0, png.rfind('.'));
+  if (_dxt_textures && _fileExists((base + ".dds").c_str())) return base + ".dds";
+  if (_etc1_textures && _fileExists((base + ".pkm").c_str())) return base + ".pkm";
+  return "";
+}
+
+// every texture with SK_TEXTURE_REPORT=1, otherwise just the totals
+static void _reportTextures() {
+  const bool all = getenv("SK_TEXTURE_REPORT") && strcmp(getenv("SK_TEXTURE_REPORT"), "0");
+  size_t bytes = 0, before = 0;
+  if (all)
+    printf("** Textures (format, texels, KB now, KB as padded png):\n");
+  for(map<string, _TextureUse>::iterator t = _texture_use.begin(); t != _texture_use.end(); ++t) {
+    const char *name = strrchr(t->first.c_str(), '/');
+    if (all)
+      printf("**   %-40s %-5s %4dx%-4d %6u %6u\n", name ? name+1 : t->first.c_str(), t->second.format.c_str(),
+	     t->second.width, t->second.height, (unsigned)(t->second.bytes/1024), (unsigned)(t->second.before/1024));
+    bytes += t->second.bytes; before += t->second.before;
+  }
+  if (!_texture_use.empty())
+    printf("** %u textures, %u KB (%u KB as padded png, %u KB saved).\n", (unsigned)_texture_use.size(),
+	   (unsigned)(bytes/1024), (unsigned)(before/1024), (unsigned)((before > bytes ? before-bytes : 0)/1024));
+}
+
+// smallest rectangle holding every pixel that is not fully transparent
+static void _opaqueBounds(const unsigned char *idata, int width, int height, int channels, int &left, int &top, int &right, int &bottom) {
+  left = width; top = height; right = bottom = 0;
+  if (channels != 2 && channels != 4) {
+    left = top = 0; right = width; bottom = height;
+    return;
+  }
+  for (int y = 0; y < height; y++) {
+    const unsigned char *row = idata + (size_t)y*width*channels + channels-1;
+    for (int x = 0; x < width; x++)
+      if (row[x*channels]) {
+	if (x < left) left = x;
+	if (x >= right) right = x+1;
+	if (y < top) top = y;
+	bottom = y+1;
+      }
+  }
+  if (left >= right) { // nothing to show
+    left = top = 0; right = bottom = 1;
+  }
+}
+
 class CcIw2DImage : public CIw2DImage
 {
 private:
   CIwIVec2 size;
   std::string file;
+  std::string resource;
   std::string error;
   uint texture;
+  size_t bytes; // of the texture, as uploaded
   float maxt, maxs;
+  float cropx, cropy, cropw, croph; // the part of the image in the texture
   const bool native;
+
+  // at its own size when the GL allows it, otherwise trimmed of its
+  // transparent border and placed in the corner of a power of two
+  // texture, never resampled
+  void Upload(unsigned char *idata, int width, int height, int channels) {
+    size.x = width; if (native) size.x /= IGDistorter::getInstance()->multiply;
+    size.y = height; if (native) size.y /= IGDistorter::getInstance()->multiply;
+
+    const size_t before = (size_t)_pot(width)*_pot(height)*channels;
+    if (_npot_textures) {
+      int w = width, h = height;
+      texture = SOIL_create_OGL_texture2(idata, w, h, channels, SOIL_CREATE_NEW_ID, SOIL_FLAG_MULTIPLY_ALPHA);
+      maxs = maxt = 1;
+      bytes = (size_t)width*height*channels;
+      _useTexture(file, "npot", width, height, bytes, before);
+    } else {
+      int left, top, right, bottom;
+      _opaqueBounds(idata, width, height, channels, left, top, right, bottom);
+      const int w = right-left, h = bottom-top;
+      int texw = _pot(w), texh = _pot(h);
+      // the last row and column run on into the padding, so filtering
+      // at the edge does not pull in black
+      unsigned char *pixels = (unsigned char*)calloc((size_t)texw*texh, channels);
+      for (int y = 0; y < texh && y <= h; y++) {
+	const unsigned char *from = idata + ((size_t)(top + (y < h ? y : h-1))*width + left)*channels;
+	unsigned char *to = pixels + (size_t)y*texw*channels;
+	memcpy(to, from, (size_t)w*channels);
+	if (w < texw) memcpy(to + (size_t)w*channels, to + (size_t)(w-1)*channels, channels);
+      }
+      texture = _headless ? _fakeTexture() : SOIL_create_OGL_texture2(pixels, texw, texh, channels, SOIL_CREATE_NEW_ID, SOIL_FLAG_MULTIPLY_ALPHA);
+      free(pixels);
+      maxs = (float)w / texw;
+      maxt = (float)h / texh;
+      cropx = (float)left / width; cropw = (float)w / width;
+      cropy = (float)top / height; croph = (float)h / height;
+      bytes = (size_t)texw*texh*channels;
+      _useTexture(file, w < width || h < height ? "trim" : "pot", texw, texh, bytes, before);
+    }
+
+    printf("CcIw2DImage image %s: texture %d, dim. %dx%d, img. %dx%d, tex. %fx%f\n", file.c_str(), texture, width, height, size.x, size.y, maxs, maxt);
+  }
+
+  // a texconv .dds or .pkm, false to fall back to the png
+  bool UploadCompressed(const string &path) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+      return false;
+    unsigned char header[128];
+    const size_t got = fread(header, 1, sizeof(header), f);
+    int width = 0, height = 0, imageWidth = 0, imageHeight = 0, channels = 4;
+    size_t bytes = 0;
+    const char *format = NULL;
+
+    if (got >= 128 && memcmp(header, "DDS ", 4) == 0) {
+      uint32 h[32]; memcpy(h, header, sizeof(h));
+      height = h[3]; width = h[4]; bytes = h[5];
+      imageWidth = width; imageHeight = height;
+      if (h[8] == _DDS_SKEY) { imageWidth = h[9]; imageHeight = h[10]; }
+      format = memcmp(header+84, "DXT1", 4) == 0 ? "DXT1" : "DXT5";
+      if (format[3] == '1') channels = 3;
+      fclose(f);
+      texture = _headless ? _fakeTexture() : SOIL_load_OGL_texture(path.c_str(), SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, SOIL_FLAG_DDS_LOAD_DIRECT);
+    } else if (got >= 16 && memcmp(header, "PKM 10", 6) == 0) {
+      width = header[8] << 8 | header[9]; height = header[10] << 8 | header[11];
+      imageWidth = header[12] << 8 | header[13]; imageHeight = header[14] << 8 | header[15];
+      bytes = (size_t)(width/4)*(height/4)*8;
+      format = "ETC1"; channels = 3;
+      vector<unsigned char> blocks(bytes);
+      fseek(f, 16, SEEK_SET);
+      const bool complete = fread(&blocks[0], 1, bytes, f) == bytes;
+      fclose(f);
+      if (!complete) {
+	fprintf(stderr, "*** Truncated texture %s.\n", path.c_str());
+	return false;
+      }
+      if (_headless)
+	texture = _fakeTexture();
+      else {
+	glGenTextures(1, &texture);
+	_bindTexture(texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_ETC1_RGB8_OES, width, height, 0, bytes, &blocks[0]);
+	if (glGetError() != GL_NO_ERROR) {
+	  glDeleteTextures(1, &texture);
+	  texture = 0;
+	}
+      }
+    } else
+      fclose(f);
+
+    if (texture == 0 || imageWidth <= 0 || imageHeight <= 0) {
+      fprintf(stderr, "*** Cannot use texture %s (%s), loading the png.\n", path.c_str(), format ? SOIL_last_result() : "unknown format");
+      if (texture && !_headless) glDeleteTextures(1, &texture);
+      texture = 0;
+      return false;
+    }
+    size.x = imageWidth; if (native) size.x /= IGDistorter::getInstance()->multiply;
+    size.y = imageHeight; if (native) size.y /= IGDistorter::getInstance()->multiply;
+    maxs = (float)imageWidth / width;
+    maxt = (float)imageHeight / height;
+    this->bytes = bytes;
+    _useTexture(file, format, width, height, bytes, (size_t)_pot(imageWidth)*_pot(imageHeight)*channels);
+    printf("CcIw2DImage image %s: texture %d from %s, dim. %dx%d, img. %dx%d, tex. %fx%f\n", file.c_str(), texture, format, width, height, size.x, size.y, maxs, maxt);
+    return true;
+  }
 public:
-  CcIw2DImage(const char* from_file, bool native = false) : texture(0), maxs(0), maxt(0), native(native) {
+  CcIw2DImage(const char* from_file, bool native = false) : texture(0), bytes(0), maxs(0), maxt(0), cropx(0), cropy(0), cropw(1), croph(1), native(native) {
 
     file = from_file;
 
+    string compressed = _compressedPath(file);
+    if (!compressed.empty() && UploadCompressed(compressed))
+      return;
+
     int width, height, channels;
     const int force_channels = 0;
     
@@ -716,34 +1604,39 @@ public:
       return;
     }
 
-    size.x = width; if (native) size.x /= IGDistorter::getInstance()->multiply;
-    size.y = height; if (native) size.y /= IGDistorter::getInstance()->multiply;
-
-    texture = SOIL_create_OGL_texture2(idata, width, height, channels, SOIL_CREATE_NEW_ID, SOIL_FLAG_POWER_OF_TWO|SOIL_FLAG_MULTIPLY_ALPHA);
+    Upload(idata, width, height, channels);
     free(idata);
-
-    maxs = maxt = 1;
-
-    printf("CcIw2DImage image %s: texture %d, dim. %dx%d, img. %dx%d, tex. %fx%f\n", from_file, texture, width, height, size.x, size.y, maxs, maxt);
+  }
+  // from pixels already decoded by the preloader (not released here)
+  CcIw2DImage(const char* from_file, unsigned char *idata, int width, int height, int channels, bool native = false) : texture(0), bytes(0), maxs(0), maxt(0), cropx(0), cropy(0), cropw(1), croph(1), native(native) {
+    file = from_file;
+    Upload(idata, width, height, channels);
   }
   virtual float GetWidth() { return size.x; }
   virtual float GetHeight()  { return size.y; }
 
   virtual ~CcIw2DImage() {
-    if (texture) glDeleteTextures( 1, &texture );
+    if (texture && !_headless) glDeleteTextures( 1, &texture );
+    if (resource.size() && --_live_images[resource] <= 0) _live_images.erase(resource);
   }
   // --
+  CcIw2DImage *SetResource(const char *name) { resource = name; _live_images[resource]++; return this; }
   const char *GetErrorString() const { error.empty()?NULL:error.c_str(); }
   uint GetTexture() const { return texture; }
+  size_t GetMemSize() const { return bytes; }
   float GetMaxS() const { return maxs; }
   float GetMaxT() const { return maxt; }
+  // shrink a destination rectangle to the part the texture holds
+  void Crop(float &x, float &y, float &w, float &h) const {
+    x += w*cropx; y += h*cropy; w *= cropw; h *= croph;
+  }
   bool IsNative() const { return native; }
 };
 
 static map<string, CcIw2DImage*> _letterbox_bg;
 static CcIw2DImage* _curr_letterbox_bg = NULL;
 
-CIw2DImage* Iw2DCreateImageResource(const char* resource)
+static const char *_findImage(const char* resource, bool &native)
 {
   const char *_search[] = { 
     "", 
@@ -766,17 +1659,152 @@ CIw2DImage* Iw2DCreateImageResource(const char* resource)
     "graphics/select_level/",
     "graphics/instructions/",
     NULL };
-  const char *path = NULL; bool native = false;
   for(char **p=(char**)_search; *p != NULL; p++) {
     const char *pp = (**p=='*')?(*p+1):*p; // skip *
     if (resourceExists(f_ssprintf("%s%s.png", pp, resource))) {
-      path = resourcePath(f_ssprintf("%s%s.png", pp, resource));
       native = (**p=='*');
+      return resourcePath(f_ssprintf("%s%s.png", pp, resource));
+    }
+  }
+  return NULL;
+}
+
+// ----- Group preloading -----
+
+// Images listed in a group manifest are decoded on the async workers.
+// Texture upload has to stay on the GL thread, so decoded images are
+// turned into textures from Iw2DFinishDrawing, a few per frame, and
+// wait there until Iw2DCreateImageResource claims them.
+
+struct _PreloadJob {
+  string name, path, group;
+  bool native, discard;
+  bool compressed; // nothing to decode, uploaded straight from the file
+  unsigned char *pixels;
+  int width, height, channels;
+  TaskId task;
+  CcIw2DImage *image;
+};
+
+static map<string, _PreloadJob*> _preload;      // by resource name
+static map<string, vector<string> > _manifests; // image names by group
+static uint32 _upload_budget_ms = 4;
+// images claimed from the preloader (compressed ones too) and loaded on the spot
+static struct { uint32 claimed, compressed, missed; } _preload_stats;
+
+static void _preloadDecode(void *userdata) {
+  _PreloadJob *job = (_PreloadJob*)userdata;
+  job->compressed = !_compressedPath(job->path).empty();
+  if (!job->compressed)
+    job->pixels = stbi_load(job->path.c_str(), &job->width, &job->height, &job->channels, 0);
+}
+
+static void _preloadFree(_PreloadJob *job) {
+  if (job->pixels) free(job->pixels);
+  delete job->image;
+  delete job;
+}
+
+static void _preloadUpload(_PreloadJob *job) {
+  if (job->image == NULL && job->compressed)
+    job->image = new CcIw2DImage(job->path.c_str(), job->native);
+  if (job->image == NULL && job->pixels) {
+    job->image = new CcIw2DImage(job->path.c_str(), job->pixels, job->width, job->height, job->channels, job->native);
+    free(job->pixels); job->pixels = NULL;
+  }
+}
+
+static const vector<string> &_readManifest(const char *grp) {
+  map<string, vector<string> >::iterator m = _manifests.find(grp);
+  if (m != _manifests.end())
+    return m->second;
+  vector<string> &names = _manifests[grp];
+  FILE *f = resourceExists(grp)?fopen(resourcePath(grp), "r"):NULL;
+  if (f == NULL) {
+    fprintf(stderr, "*** Group manifest %s not found.\n", grp);
+    return names;
+  }
+  // pick every quoted "*.png" entry and keep its base name:
+  char line[FILENAME_MAX];
+  while(fgets(line, sizeof(line), f)) {
+    char *b = strchr(line, '"'), *e = b?strchr(b+1, '"'):NULL;
+    if (e == NULL || e-b < 5 || strncmp(e-4, ".png", 4)) continue;
+    *(e-4) = 0;
+    const char *base = strrchr(b+1, '/');
+    names.push_back(base?base+1:b+1);
+  }
+  fclose(f);
+  return names;
+}
+
+static void _preloadGroup(const char *grp) {
+  const vector<string> &names = _readManifest(grp);
+  for(vector<string>::const_iterator n = names.begin(); n != names.end(); ++n) {
+    const string &name = *n;
+    if (_live_images.count(name))
+      continue;
+    map<string, _PreloadJob*>::iterator j = _preload.find(name);
+    if (j != _preload.end()) {
+      j->second->group = grp; j->second->discard = false;
+      continue;
+    }
+    bool native = false; const char *path = _findImage(name.c_str(), native);
+    if (path == NULL)
+      continue;
+    _PreloadJob *job = new _PreloadJob();
+    job->name = name; job->path = path; job->group = grp;
+    job->native = native; job->discard = false; job->compressed = false;
+    job->pixels = NULL; job->image = NULL;
+    _preload[name] = job;
+    job->task = async_run(_preloadDecode, job);
+  }
+}
+
+// upload decoded images until the frame budget is used up
+static void _preloadPump(uint32 budget) {
+  const uint32 start = SDL_GetTicks();
+  map<string, _PreloadJob*>::iterator j = _preload.begin();
+  while(j != _preload.end()) {
+    _PreloadJob *job = j->second;
+    if (!async_is_finished(job->task)) {
+      ++j; continue;
+    }
+    // unclaimed jobs of other groups go, uploaded or not
+    if (job->discard || (job->image == NULL && job->pixels == NULL && !job->compressed)) {
+      _preloadFree(job); _preload.erase(j++); continue;
+    }
+    if (job->image) {
+      ++j; continue;
+    }
+    if (SDL_GetTicks() - start >= budget)
       break;
+    _preloadUpload(job); ++j;
+  }
+}
+
+CIw2DImage* Iw2DCreateImageResource(const char* resource)
+{
+  // take over image from the preloader, waiting for the decode if needed:
+  map<string, _PreloadJob*>::iterator j = _preload.find(resource);
+  if (j != _preload.end()) {
+    _PreloadJob *job = j->second; _preload.erase(j);
+    while(!async_is_finished(job->task))
+      SDL_Delay(1);
+    _preloadUpload(job);
+    CcIw2DImage *image = job->image; job->image = NULL;
+    const bool compressed = job->compressed;
+    _preloadFree(job);
+    if (image) {
+      _preload_stats.claimed++;
+      if (compressed) _preload_stats.compressed++;
+      return image->SetResource(resource);
     }
   }
+  _preload_stats.missed++;
+
+  bool native = false; const char *path = _findImage(resource, native);
   if (path) {
-    return new CcIw2DImage(path, native);
+    return (new CcIw2DImage(path, native))->SetResource(resource);
   } else {
     fprintf(stderr, "*** Resource image %s not found.\n", resource);
     return NULL;
@@ -792,6 +1820,18 @@ CIw2DFont* Iw2DCreateFontResource(const char* resource)
   return NULL;
 }
 
+uint32 Iw2DGetImageMemSize(CIw2DImage* image) {
+  return image ? (uint32)((CcIw2DImage*)image)->GetMemSize() : 0;
+}
+
+uint32 Iw2DGetFontMemSize(CIw2DFont* font) {
+  return font ? (uint32)((CcIw2DFont*)font)->GetMemSize() : 0;
+}
+
+uint32 Iw2DGetFontTexture(CIw2DFont* font) {
+  return font ? (uint32)((CcIw2DFont*)font)->GetTexture() : 0;
+}
+
 uint32 Iw2DGetSurfaceWidth() { return screen_width; }
 
 uint32 Iw2DGetSurfaceHeight() { return screen_height; }
@@ -799,7 +1839,7 @@ uint32 Iw2DGetSurfaceHeight() { return screen_height; }
 void Iw2DSetTransformMatrix(const CIwMat2D &m) {
   printf("*** Applying new transformation matrix.\n");
   _current_matrix = m;
-  glLoadMatrixf(AffineTransform::matrix(_current_matrix)());
+  if (!_headless) glLoadMatrixf(AffineTransform::matrix(_current_matrix)());
 }
 
 void Iw2DSetFont(const CIw2DFont *f) {
@@ -838,16 +1878,50 @@ static std::pair<int,int> _text_size(const char* text, std::vector<int> &lines_w
   return std::pair<int,int>(len,height);
 }
 
-void Iw2DDrawString(const char* text, CIwSVec2 topLeft, CIwSVec2 size, CIw2DFontAlign horzAlign, CIw2DFontAlign vertAlign) {
+// ----- Text layout cache -----
 
-  if (!*text) return; // nothing to draw
+// Laid out strings are kept as ready to draw glyph quads, relative to the
+// top left corner of their box, and drawn with a single call.
+
+struct _GlyphVertex {
+  GLfloat v[2];
+  GLfloat t[2];
+  uint32_t c;
+};
+
+struct _TextKey {
+  const CcIw2DFont *font;
+  string text;
+  int16 w, h;
+  int8 halign, valign;
+  bool operator<(const _TextKey &k) const {
+    if (font != k.font) return font < k.font;
+    if (w != k.w) return w < k.w;
+    if (h != k.h) return h < k.h;
+    if (halign != k.halign) return halign < k.halign;
+    if (valign != k.valign) return valign < k.valign;
+    return text < k.text;
+  }
+};
+
+struct _TextRun {
+  vector<_GlyphVertex> vertices;
+  uint32_t color;
+  uint32 area; // covered pixels, for the stats
+};
+
+#define MAX_TEXT_RUNS 512
+
+static map<_TextKey, _TextRun> _text_runs;
+
+static void _layout_text(_TextRun &run, const char* text, CIwSVec2 size, CIw2DFontAlign horzAlign, CIw2DFontAlign vertAlign) {
 
   std::vector<int> lines_width;
   const std::pair<int,int> &sz = _text_size(text, lines_width);
 
   int ln = 0;
-  float x = topLeft.x, xs = topLeft.x;
-  float y = topLeft.y;
+  float x = 0, xs = 0;
+  float y = 0;
   if (horzAlign == IW_2D_FONT_ALIGN_CENTRE) {
     x += (size.x - lines_width[ln]) / 2.;
   }
@@ -862,8 +1936,7 @@ void Iw2DDrawString(const char* text, CIwSVec2 topLeft, CIwSVec2 size, CIw2DFont
     fprintf( stderr, "[Iw2DDrawString] This part is fine and will be processed: %s.\n", string(line.begin(), end_it).c_str() );
   }
   utf8::iterator<string::iterator> it (line.begin(), line.begin(), end_it);
-  glBindTexture(GL_TEXTURE_2D, _current_font->GetTexture());
-  int index = 0; while(it.base()!=end_it) {
+  while(it.base()!=end_it) {
     const uint32_t ch = *it;
 
     if (ch == '\n') {
@@ -880,24 +1953,78 @@ void Iw2DDrawString(const char* text, CIwSVec2 topLeft, CIwSVec2 size, CIw2DFont
       const int h = box.y2 - box.y1;
       const int w = box.x2 - box.x1;
 
-      struct _v2c4 {
-	GLfloat v[2];
-	GLfloat t[2];
-	uint32_t c;
-      } vertices[] = {
-	{ {x, y}, {coord.x1, coord.y1}, _current_color },
-	{ {x, y+h}, {coord.x1, coord.y2}, _current_color },
-	{ {x+w, y}, {coord.x2, coord.y1}, _current_color },
-	{ {x+w, y+h}, {coord.x2, coord.y2}, _current_color },
+      // two triangles per glyph
+      const _GlyphVertex quad[] = {
+	{ {x, y}, {coord.x1, coord.y1}, run.color },
+	{ {x, y+h}, {coord.x1, coord.y2}, run.color },
+	{ {x+w, y}, {coord.x2, coord.y1}, run.color },
+	{ {x+w, y}, {coord.x2, coord.y1}, run.color },
+	{ {x, y+h}, {coord.x1, coord.y2}, run.color },
+	{ {x+w, y+h}, {coord.x2, coord.y2}, run.color },
       };
-      glVertexPointer(2, GL_FLOAT, sizeof(_v2c4), vertices->v);
-      glTexCoordPointer(2, GL_FLOAT, sizeof(_v2c4), vertices->t);
-      glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(_v2c4), &vertices->c);
-      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+      run.vertices.insert(run.vertices.end(), quad, quad+6);
+      run.area += w * h;
 
       x += w;
     }
-    it++;;
+    it++;
+  }
+}
+
+void Iw2DDrawString(const char* text, CIwSVec2 topLeft, CIwSVec2 size, CIw2DFontAlign horzAlign, CIw2DFontAlign vertAlign) {
+
+  if (!*text) return; // nothing to draw
+
+  const _TextKey key = { _current_font, text, (int16)size.x, (int16)size.y, (int8)horzAlign, (int8)vertAlign };
+  map<_TextKey, _TextRun>::iterator r = _text_runs.find(key);
+  if (r == _text_runs.end()) {
+    if (_text_runs.size() >= MAX_TEXT_RUNS)
+      _text_runs.clear(); // strings not going through labels
+    r = _text_runs.insert(std::make_pair(key, _TextRun())).first;
+    r->second.color = _current_color;
+    r->second.area = 0;
+    _layout_text(r->second, text, size, horzAlign, vertAlign);
+  }
+  _TextRun &run = r->second;
+  if (run.vertices.empty()) return;
+  if (run.color != _current_color) {
+    run.color = _current_color;
+    for(vector<_GlyphVertex>::iterator v = run.vertices.begin(); v != run.vertices.end(); ++v)
+      v->c = run.color;
+  }
+
+  _stats.draws++;
+  _stats.vertices += run.vertices.size();
+  _stats.pixels += run.area;
+  _bindTexture(_current_font->GetTexture());
+  if (_headless) return;
+
+  glPushMatrix();
+  glTranslatef(topLeft.x, topLeft.y, 0);
+  glVertexPointer(2, GL_FLOAT, sizeof(_GlyphVertex), run.vertices[0].v);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(_GlyphVertex), run.vertices[0].t);
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(_GlyphVertex), &run.vertices[0].c);
+  glDrawArrays(GL_TRIANGLES, 0, run.vertices.size());
+  glPopMatrix();
+}
+
+void Iw2DReleaseString(const CIw2DFont *font, const char* text) {
+  map<_TextKey, _TextRun>::iterator r = _text_runs.begin();
+  while(r != _text_runs.end()) {
+    if (r->first.font == font && r->first.text == text)
+      _text_runs.erase(r++);
+    else
+      ++r;
+  }
+}
+
+static void _release_font_strings(const CcIw2DFont *font) {
+  map<_TextKey, _TextRun>::iterator r = _text_runs.begin();
+  while(r != _text_runs.end()) {
+    if (r->first.font == font)
+      _text_runs.erase(r++);
+    else
+      ++r;
   }
 }
 
@@ -905,10 +2032,11 @@ void Iw2DDrawImage(CIw2DImage* image, CIwSVec2 topLeft, CIwSVec2 size) {
 
   CcIw2DImage* img = dynamic_cast<CcIw2DImage*>(image);
 
-  const float x = topLeft.x;
-  const float y = topLeft.y;
-  const float w = size.x;
-  const float h = size.y;
+  float x = topLeft.x;
+  float y = topLeft.y;
+  float w = size.x;
+  float h = size.y;
+  img->Crop(x, y, w, h);
   float uofs = 0;
   float vofs = 0;
   const float uwid = img->GetMaxS();
@@ -924,14 +2052,180 @@ void Iw2DDrawImage(CIw2DImage* image, CIwSVec2 topLeft, CIwSVec2 size) {
     { {x+w, y}, {uofs+uwid, vofs}, _current_color },
     { {x+w, y+h}, {uofs+uwid, vofs+vwid}, _current_color },
   };
-  glBindTexture(GL_TEXTURE_2D, img->GetTexture());
+  _stats.draws++;
+  _stats.vertices += 4;
+  _stats.pixels += (uint64)fabs(w * h);
+  _bindTexture(img->GetTexture());
+  if (_headless) return;
   glVertexPointer(2, GL_FLOAT, sizeof(_v2c4), vertices->v);
   glTexCoordPointer(2, GL_FLOAT, sizeof(_v2c4), vertices->t);
   glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(_v2c4), &vertices->c);
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); 
 }
 
+void Iw2DFillRect(CIwSVec2 topLeft, CIwSVec2 size) {
+
+  const float x = topLeft.x;
+  const float y = topLeft.y;
+  const float w = size.x;
+  const float h = size.y;
+
+  struct _v2c4 {
+    GLfloat v[2];
+    uint32_t c;
+  } vertices[] = {
+    { {x, y}, _current_color },
+    { {x, y+h}, _current_color },
+    { {x+w, y}, _current_color },
+    { {x+w, y+h}, _current_color },
+  };
+  _stats.draws++;
+  _stats.vertices += 4;
+  _stats.pixels += (uint64)abs(size.x * size.y);
+  if (_headless) return;
+  glDisable(GL_TEXTURE_2D);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glVertexPointer(2, GL_FLOAT, sizeof(_v2c4), vertices->v);
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(_v2c4), &vertices->c);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnable(GL_TEXTURE_2D);
+}
+
+// Quad batches keep their vertices in a buffer object; a changed quad
+// uploads just its six vertices, and the index list that groups quads
+// by texture is rebuilt only when a quad changes image.
+
+struct _QuadVertex {
+  GLfloat v[2];
+  GLfloat t[2];
+};
+
+class CIw2DQuadBatch
+{
+public:
+  vector<_QuadVertex> vertices; // six per quad
+  vector<CcIw2DImage*> images;  // per quad, NULL when hidden
+  vector<uint32> areas;         // per quad, for the stats
+  vector<GLushort> indices;     // visible quads, grouped by texture
+  struct Group { uint texture; int first, count; uint32 area; };
+  vector<Group> groups;
+  GLuint buffer;
+  int dirtyFirst, dirtyLast;    // quads to upload
+  bool regroup;
+};
+
+CIw2DQuadBatch* Iw2DCreateQuadBatch(int quads) {
+  CIw2DQuadBatch *batch = new CIw2DQuadBatch();
+  batch->vertices.resize(quads * 6);
+  batch->images.assign(quads, (CcIw2DImage*)NULL);
+  batch->areas.assign(quads, 0);
+  batch->buffer = 0;
+  batch->dirtyFirst = quads; batch->dirtyLast = -1;
+  batch->regroup = true;
+  if (!_headless && quads > 0) {
+    glGenBuffers(1, &batch->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    glBufferData(GL_ARRAY_BUFFER, batch->vertices.size() * sizeof(_QuadVertex), &batch->vertices[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  return batch;
+}
+
+void Iw2DSetQuad(CIw2DQuadBatch* batch, int quad, CIw2DImage* image, CIwSVec2 topLeft, CIwSVec2 size) {
+  CcIw2DImage* img = dynamic_cast<CcIw2DImage*>(image);
+  if (img != batch->images[quad]) {
+    batch->images[quad] = img;
+    batch->regroup = true;
+  }
+  if (img == NULL)
+    return;
+
+  float x = topLeft.x;
+  float y = topLeft.y;
+  float w = size.x;
+  float h = size.y;
+  img->Crop(x, y, w, h);
+  const float s = img->GetMaxS();
+  const float t = img->GetMaxT();
+  const _QuadVertex quadVertices[] = {
+    { {x, y}, {0, 0} },
+    { {x, y+h}, {0, t} },
+    { {x+w, y}, {s, 0} },
+    { {x+w, y}, {s, 0} },
+    { {x, y+h}, {0, t} },
+    { {x+w, y+h}, {s, t} },
+  };
+  std::copy(quadVertices, quadVertices+6, batch->vertices.begin() + quad*6);
+  batch->areas[quad] = (int)fabs(w * h);
+  if (quad < batch->dirtyFirst) batch->dirtyFirst = quad;
+  if (quad > batch->dirtyLast) batch->dirtyLast = quad;
+}
+
+static void _regroupQuads(CIw2DQuadBatch* batch) {
+  map<uint, vector<int> > quads;
+  for(int q = 0; q < (int)batch->images.size(); ++q)
+    if (batch->images[q])
+      quads[batch->images[q]->GetTexture()].push_back(q);
+  batch->indices.clear();
+  batch->groups.clear();
+  for(map<uint, vector<int> >::iterator g = quads.begin(); g != quads.end(); ++g) {
+    CIw2DQuadBatch::Group group = { g->first, (int)batch->indices.size(), 0, 0 };
+    for(vector<int>::iterator q = g->second.begin(); q != g->second.end(); ++q) {
+      for(int i = 0; i < 6; ++i)
+	batch->indices.push_back(*q*6 + i);
+      group.area += batch->areas[*q];
+    }
+    group.count = batch->indices.size() - group.first;
+    batch->groups.push_back(group);
+  }
+  batch->regroup = false;
+}
+
+void Iw2DDrawQuadBatch(CIw2DQuadBatch* batch) {
+  if (batch->regroup)
+    _regroupQuads(batch);
+  if (!_headless && batch->dirtyLast >= batch->dirtyFirst) {
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, batch->dirtyFirst * 6 * sizeof(_QuadVertex),
+		    (batch->dirtyLast - batch->dirtyFirst + 1) * 6 * sizeof(_QuadVertex), &batch->vertices[batch->dirtyFirst * 6]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  batch->dirtyFirst = batch->images.size(); batch->dirtyLast = -1;
+  if (batch->groups.empty())
+    return;
+
+  if (!_headless) {
+    glBindBuffer(GL_ARRAY_BUFFER, batch->buffer);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glColor4ub(_current_color & 0xff, (_current_color >> 8) & 0xff, (_current_color >> 16) & 0xff, _current_color >> 24);
+    glVertexPointer(2, GL_FLOAT, sizeof(_QuadVertex), (const GLvoid*)offsetof(_QuadVertex, v));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(_QuadVertex), (const GLvoid*)offsetof(_QuadVertex, t));
+  }
+  for(vector<CIw2DQuadBatch::Group>::iterator g = batch->groups.begin(); g != batch->groups.end(); ++g) {
+    _stats.draws++;
+    _stats.vertices += g->count;
+    _stats.pixels += g->area;
+    _bindTexture(g->texture);
+    if (!_headless)
+      glDrawElements(GL_TRIANGLES, g->count, GL_UNSIGNED_SHORT, &batch->indices[g->first]);
+  }
+  if (!_headless) {
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnableClientState(GL_COLOR_ARRAY);
+  }
+}
+
+void Iw2DDestroyQuadBatch(CIw2DQuadBatch* batch) {
+  if (batch->buffer && !_headless)
+    glDeleteBuffers(1, &batch->buffer);
+  delete batch;
+}
+
 void Iw2DClearScreen(const uint32 color) {
+  _stats.clears++;
+  _stats.pixels += screen_width * screen_height;
+  if (_headless) return;
 #ifdef __PLAYBOOK__
 
   static float mx = 0, my = 0;
@@ -999,14 +2293,7 @@ void Iw2DClearScreen(const uint32 color) {
     }
 }
 
-void Iw2DInit() {
-
-  // force/switch to landscape:
-#if defined __QNXNTO__
-  printf("** Locking to orientation portrait.\n");
-  navigator_rotation_lock(true);
-#endif
-
+static void _initVideo() {
   if (SDL_Init(SDL_INIT_VIDEO)<0) exit(1);
 
 #ifdef SDL_HINT_MERGE_MOUSE_MOTION_EVENTS
@@ -1043,6 +2330,28 @@ void Iw2DInit() {
     glEnableClientState(GL_COLOR_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
+    _queryTextureFormats();
+}
+
+void Iw2DInit() {
+
+  // force/switch to landscape:
+#if defined __QNXNTO__
+  printf("** Locking to orientation portrait.\n");
+  navigator_rotation_lock(true);
+#endif
+
+  const char *script = getenv("SK_SCRIPT");
+  if (script) _loadScript(script);
+  _headless = getenv("SK_HEADLESS") && strcmp(getenv("SK_HEADLESS"), "0");
+  if (_headless) {
+    printf("** Headless rendering, nothing will be displayed.\n");
+    if (SDL_Init(SDL_INIT_TIMER)<0) exit(1);
+  } else
+    _initVideo();
+  _script_start = SDL_GetTicks();
+  _recOpen();
+
     // dgreed utils:
     async_init();
     log_init(NULL, LOG_LEVEL_INFO);
@@ -1055,6 +2364,22 @@ void Iw2DInit() {
 }
 
 void Iw2DTerminate() {
+  for(map<string, _PreloadJob*>::iterator j = _preload.begin(); j != _preload.end(); ++j) {
+    while(!async_is_finished(j->second->task))
+      SDL_Delay(1);
+    _preloadFree(j->second);
+  }
+  _preload.clear();
+  _recClose();
+  if (_headless)
+    printf("** Rendered %u frames: %u clears, %u draws, %u texture binds, %u vertices, %llu pixels.\n",
+	   _stats.frames, _stats.clears, _stats.draws, _stats.binds, _stats.vertices, (unsigned long long)_stats.pixels);
+  _reportTextures();
+  if (_preload_stats.claimed + _preload_stats.missed)
+    printf("** Preloaded %u images (%u compressed), %u loaded on demand.\n",
+	   _preload_stats.claimed, _preload_stats.compressed, _preload_stats.missed);
+  audioThreadShutdown();
+  _music_streamed = false;
   SDL_Quit();
   // dgreed utils:
   loc_close();
@@ -1066,8 +2391,19 @@ void Iw2DTerminate() {
 void Iw2DSurfaceShow() {
 }
 
+void Iw2DGetStats(Iw2DStats &stats) {
+  stats = _stats;
+}
+
+void Iw2DResetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+  _stats_texture = 0;
+}
+
 void Iw2DFinishDrawing() {
-  SDL_GL_SwapBuffers();
+  _stats.frames++;
+  if (!_headless) SDL_GL_SwapBuffers();
+  _preloadPump(_upload_budget_ms);
   SDL_Delay(0);
 #ifdef DEBUG
   fflush(stdout);
@@ -1078,6 +2414,10 @@ void Iw2DFinishDrawing() {
 
 void IwGetResManagerS::LoadGroup(const char *grp) {
     group = grp; 
+    // drop what was preloaded for other groups and never claimed:
+    for(map<string, _PreloadJob*>::iterator j = _preload.begin(); j != _preload.end(); ++j)
+      if (j->second->group != grp) j->second->discard = true;
+    _preloadGroup(grp);
     // look for playbook background:
 #if ENABLE_ANIM_BG
     _curr_letterbox_bg = _letterbox_bg[grp];
@@ -1111,6 +2451,30 @@ void IwGetResManagerS::LoadGroup(const char *grp) {
 #endif
 }
 
+void IwGetResManagerS::PreloadGroup(const char *grp) {
+  _preloadGroup(grp);
+}
+
+float IwGetResManagerS::GetGroupProgress(const char *grp) {
+  const vector<string> &names = _readManifest(grp);
+  int ready = 0, total = 0;
+  for(vector<string>::const_iterator n = names.begin(); n != names.end(); ++n) {
+    if (_live_images.count(*n)) {
+      ready++; total++;
+    } else {
+      map<string, _PreloadJob*>::iterator j = _preload.find(*n);
+      if (j == _preload.end()) continue; // not requested or not found
+      if (j->second->image) ready++;
+      total++;
+    }
+  }
+  return total?float(ready)/total:1;
+}
+
+void IwGetResManagerS::SetUploadBudget(uint32 ms) {
+  _upload_budget_ms = ms;
+}
+
 // -- Scoreboard support
 
 #define SCORE_SUBMIT_ACTION  1
@@ -51,6 +51,7 @@ enum s3eEnum {
   S3E_SOUND_DEFAULT_FREQ,
   S3E_SOUND_VOLUME,
   S3E_AUDIO_VOLUME,
+  S3E_AUDIO_UNDERRUNS, // compat: streamed music that ran dry
   S3E_IOSBACKGROUNDMUSIC_PLAYBACK_STATE,
   S3E_IOSBACKGROUNDMUSIC_PLAYBACK_PLAYING,
   S3E_IOSBACKGROUNDMUSIC_PLAYBACK_INTERRUPTED
@@ -71,12 +72,20 @@ typedef FILE s3eFile;
 
 s3eFile* s3eFileOpen(const char* filename, const char* mode);
 inline static s3eResult s3eFileClose(s3eFile* file) { return fclose(file)?S3E_RESULT_ERROR:S3E_RESULT_SUCCESS; }
-inline static uint32 s3eFileRead(void* buffer, uint32 elemSize, uint32 noElems, s3eFile* file) { return fwrite(buffer, elemSize, noElems, file); }
-inline static uint32 s3eFileWrite(void* buffer, uint32 elemSize, uint32 noElems, s3eFile* file)  { return fread(buffer, elemSize, noElems, file); }
+inline static uint32 s3eFileRead(void* buffer, uint32 elemSize, uint32 noElems, s3eFile* file) { return fread(buffer, elemSize, noElems, file); }
+inline static uint32 s3eFileWrite(const void* buffer, uint32 elemSize, uint32 noElems, s3eFile* file)  { return fwrite(buffer, elemSize, noElems, file); }
 int32 s3eFileGetSize(s3eFile* file);
 
-inline static uint32 s3eTimerGetMs() { return SDL_GetTicks(); }
-inline static void s3eDeviceYield(int ms) { }
+// both go through the input recorder (SK_RECORD/SK_REPLAY)
+uint32 s3eTimerGetMs();
+void s3eDeviceYield(int ms);
+// monotonic and never recorded, for measuring
+inline static uint64 s3eTimerGetUSTNanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+void s3eDeviceYieldUntilEvent(int ms);
 inline static s3eResult s3eConfigGetString(const char *conf, const char *sect, char *buffer) {
   return S3E_RESULT_SUCCESS;
 }
@@ -108,9 +117,26 @@ s3eResult s3eAudioResume();
 void s3eAudioStop();
 s3eBool s3eAudioIsPlaying();
 void s3eAudioSetInt(s3eEnum f, int v);
+int32 s3eAudioGetInt(s3eEnum f);
+// compat: fade from the music playing to filename over ms
+s3eResult s3eAudioCrossfade(const char* filename, uint32 repeatCount, int32 ms);
+// compat: the files in turn, each fading into the next before it ends
+s3eResult s3eAudioPlaylist(const char** filenames, int count, int32 ms);
 
 s3eResult s3eSoundChannelPlay(int channel, int16* start, uint32 numSamples, int32 repeat, int32 loopfrom);
 int s3eSoundGetFreeChannel();
+// compat sound bank: upload a sample once, then play it by handle on a
+// fixed pool of voices; when they are all busy a sound takes the voice of
+// one with no higher priority, or is dropped. The samples are copied on
+// register, the caller can free them straight after.
+int s3eSoundBankRegister(int16* start, uint32 numSamples, int priority S3E_DEFAULT(0), int maxInstances S3E_DEFAULT(0)); // -1 on error
+void s3eSoundBankUnregister(int handle);
+int s3eSoundBankPlay(int handle, int32 repeat S3E_DEFAULT(1), int volume S3E_DEFAULT(256)); // the voice, or -1
+struct s3eSoundBankStats { uint32 plays, steals, drops, voices, busy; };
+void s3eSoundBankGetStats(s3eSoundBankStats* stats);
+// with SK_SOUND=null the effects are mixed only when asked, into 16 bit mono
+s3eResult s3eSoundMixerRender(int16* out, int frames);
+void s3eSoundStopAllChannels();
 const char* s3eSoundGetErrorString();
 void s3eSoundSetInt(s3eEnum f, int v);
 
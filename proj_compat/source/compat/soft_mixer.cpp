@@ -0,0 +1,273 @@
+#include "soft_mixer.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+using std::vector;
+
+#define MIX_CHUNK 256 // frames summed at a time
+#define MIX_DEVICE_FRAMES 1024 // the SDL buffer, 23 ms at 44.1 kHz
+
+struct _MixSample {
+  vector<int16> data;
+  uint32 step; // 16.16, sample rate over output rate
+  bool used;
+};
+
+struct _MixVoice {
+  int sample; // -1 when idle
+  uint32 pos, frac; // frac in 16 bits
+  bool loop;
+  int gain; // 0..256
+};
+
+static vector<_MixSample> _samples;
+static _MixVoice _voices[SOFT_MIXER_VOICES];
+static int _rate = 44100;
+static int _master = 256;
+static bool _ready = false, _sdl = false, _atexit = false;
+static SoftMixerStats _stats;
+
+// the SDL callback runs under the audio lock, the game thread takes it
+// around every change to what the callback reads
+static void _lock() {
+  if (_sdl)
+    SDL_LockAudio();
+}
+
+static void _unlock() {
+  if (_sdl)
+    SDL_UnlockAudio();
+}
+
+static uint64 _nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+// acc += src*gain, the common case of a sample at the output rate
+static void _accumulate(int32 *acc, const int16 *src, int n, int gain) {
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i g = _mm_set1_epi16((short)gain);
+  for (; i+8 <= n; i += 8) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+    // 16x16 bit products, put back together as 32 bits
+    __m128i lo = _mm_mullo_epi16(s, g), hi = _mm_mulhi_epi16(s, g);
+    __m128i *a = (__m128i*)(acc + i);
+    _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, hi)));
+    _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, hi)));
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  const int16x4_t g = vdup_n_s16((int16)gain);
+  for (; i+8 <= n; i += 8) {
+    int16x8_t s = vld1q_s16(src + i);
+    vst1q_s32(acc + i, vmlal_s16(vld1q_s32(acc + i), vget_low_s16(s), g));
+    vst1q_s32(acc + i + 4, vmlal_s16(vld1q_s32(acc + i + 4), vget_high_s16(s), g));
+  }
+#endif
+  for (; i<n; ++i)
+    acc[i] += src[i]*gain;
+}
+
+// out = acc/256, clamped to 16 bits
+static void _saturate(int16 *out, const int32 *acc, int n) {
+  int i = 0;
+#if defined(__SSE2__)
+  for (; i+8 <= n; i += 8) {
+    __m128i a0 = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(acc + i)), 8);
+    __m128i a1 = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(acc + i + 4)), 8);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a0, a1));
+  }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  for (; i+8 <= n; i += 8)
+    vst1q_s16(out + i, vcombine_s16(vqshrn_n_s32(vld1q_s32(acc + i), 8), vqshrn_n_s32(vld1q_s32(acc + i + 4), 8)));
+#endif
+  for (; i<n; ++i) {
+    int32 v = acc[i] >> 8;
+    out[i] = (int16)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+  }
+}
+
+// adds n frames of the voice to acc, returns the frames it had
+static int _mixVoice(_MixVoice &v, int32 *acc, int n) {
+  const _MixSample &sample = _samples[v.sample];
+  const uint32 count = sample.data.size();
+  const int16 *src = count ? &sample.data[0] : NULL;
+  const int gain = v.gain * _master >> 8;
+  int done = 0;
+  while (done < n) {
+    if (v.pos >= count) {
+      if (!v.loop || count == 0) {
+	v.sample = -1;
+	break;
+      }
+      v.pos %= count;
+    }
+    if (sample.step == 0x10000 && v.frac == 0) {
+      int m = n - done;
+      if ((uint32)m > count - v.pos)
+	m = count - v.pos;
+      _accumulate(acc + done, src + v.pos, m, gain);
+      v.pos += m;
+      done += m;
+      continue;
+    }
+    // linear between neighbours; the last one leads into the loop or silence
+    for (; done < n && v.pos < count; ++done) {
+      int a = src[v.pos];
+      int b = v.pos + 1 < count ? src[v.pos + 1] : (v.loop ? src[0] : 0);
+      int s = a + (int)(((int64)(b - a) * (int64)v.frac) >> 16);
+      acc[done] += s*gain;
+      v.frac += sample.step;
+      v.pos += v.frac >> 16;
+      v.frac &= 0xffff;
+    }
+  }
+  return done;
+}
+
+void softMixerRender(int16* out, int frames) {
+  const uint64 start = _nowNs();
+  int32 acc[MIX_CHUNK];
+  _stats.frames += frames;
+  while (frames > 0) {
+    int n = frames < MIX_CHUNK ? frames : MIX_CHUNK;
+    memset(acc, 0, n*sizeof(int32));
+    for (int v=0; v<SOFT_MIXER_VOICES; ++v)
+      if (_voices[v].sample >= 0)
+	_stats.voiceFrames += _mixVoice(_voices[v], acc, n);
+    _saturate(out, acc, n);
+    out += n;
+    frames -= n;
+  }
+  _stats.ns += _nowNs() - start;
+}
+
+static void _callback(void*, Uint8 *stream, int len) {
+  softMixerRender((int16*)stream, len / (int)sizeof(int16));
+}
+
+bool softMixerInit(int rate, bool nullSink) {
+  if (_ready)
+    return true;
+  _rate = rate;
+  for (int v=0; v<SOFT_MIXER_VOICES; ++v)
+    _voices[v].sample = -1;
+  memset(&_stats, 0, sizeof(_stats));
+  if (!nullSink) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+      fprintf(stderr, "*** software mixer: no SDL audio: %s\n", SDL_GetError());
+      return false;
+    }
+    // no obtained spec, so SDL converts to the device if it has to
+    SDL_AudioSpec want;
+    memset(&want, 0, sizeof(want));
+    want.freq = rate;
+    want.format = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples = MIX_DEVICE_FRAMES;
+    want.callback = _callback;
+    if (SDL_OpenAudio(&want, NULL) < 0) {
+      fprintf(stderr, "*** software mixer: cannot open audio: %s\n", SDL_GetError());
+      SDL_QuitSubSystem(SDL_INIT_AUDIO);
+      return false;
+    }
+    _sdl = true;
+    SDL_PauseAudio(0);
+  }
+  _ready = true;
+  printf("** Software mixer at %d Hz%s.\n", rate, nullSink ? ", null sink" : "");
+  if (!_atexit)
+    atexit(softMixerShutdown);
+  _atexit = true;
+  return true;
+}
+
+void softMixerShutdown() {
+  if (!_ready)
+    return;
+  if (_sdl) {
+    SDL_CloseAudio();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+  }
+  _sdl = _ready = false;
+  if (_stats.frames)
+    printf("** Software mixer: %llu frames, %llu from voices, %.1f ns per frame.\n",
+	   (unsigned long long)_stats.frames, (unsigned long long)_stats.voiceFrames,
+	   (double)_stats.ns / _stats.frames);
+  _samples.clear();
+}
+
+int softMixerAddSample(const int16* samples, uint32 count, int rate) {
+  if (rate <= 0) {
+    fprintf(stderr, "*** software mixer: bad sample rate %d.\n", rate);
+    return -1;
+  }
+  _lock();
+  int s = 0;
+  while (s < (int)_samples.size() && _samples[s].used)
+    s++;
+  if (s == (int)_samples.size())
+    _samples.push_back(_MixSample());
+  _MixSample &sample = _samples[s];
+  sample.data.assign(samples, samples + count);
+  sample.step = (uint32)(((uint64)rate << 16) / _rate);
+  sample.used = true;
+  _unlock();
+  return s;
+}
+
+void softMixerRemoveSample(int sample) {
+  if (sample < 0 || sample >= (int)_samples.size())
+    return;
+  _lock();
+  for (int v=0; v<SOFT_MIXER_VOICES; ++v)
+    if (_voices[v].sample == sample)
+      _voices[v].sample = -1;
+  vector<int16>().swap(_samples[sample].data);
+  _samples[sample].used = false;
+  _unlock();
+}
+
+void softMixerPlay(int voice, int sample, bool loop, int volume) {
+  if (voice < 0 || voice >= SOFT_MIXER_VOICES || sample < 0 || sample >= (int)_samples.size() || !_samples[sample].used)
+    return;
+  _lock();
+  _MixVoice &v = _voices[voice];
+  v.sample = sample;
+  v.pos = v.frac = 0;
+  v.loop = loop;
+  v.gain = volume < 0 ? 0 : (volume > 256 ? 256 : volume);
+  _unlock();
+}
+
+void softMixerStop(int voice) {
+  if (voice < 0 || voice >= SOFT_MIXER_VOICES)
+    return;
+  _lock();
+  _voices[voice].sample = -1;
+  _unlock();
+}
+
+void softMixerSetVolume(int volume) {
+  _lock();
+  _master = volume < 0 ? 0 : (volume > 256 ? 256 : volume);
+  _unlock();
+}
+
+void softMixerGetStats(SoftMixerStats* stats) {
+  _lock();
+  *stats = _stats;
+  _unlock();
+}
@@ -0,0 +1,41 @@
+#ifndef SOFT_MIXER_H
+#define SOFT_MIXER_H
+
+#include "s3eTypes.h"
+
+// Sound effects mixed in software into one 16 bit mono stream.
+//
+// Voices hold a sample, a gain and a position stepping through it at the
+// sample's rate over the output rate; all of them are summed in 32 bits
+// and saturated back to 16 (SSE2 or NEON when built for them). The stream
+// goes to an SDL audio callback, or with the null sink nowhere at all: then
+// whoever wants the sound calls softMixerRender, at whatever pace.
+//
+// All functions but softMixerRender are for the game thread only.
+
+#define SOFT_MIXER_VOICES 32
+
+// false when the SDL device can't be opened
+bool softMixerInit(int rate, bool nullSink);
+void softMixerShutdown();
+
+// the samples are copied; -1 on error
+int softMixerAddSample(const int16* samples, uint32 count, int rate);
+void softMixerRemoveSample(int sample);
+
+// volume 0..256; a looping voice plays until stopped
+void softMixerPlay(int voice, int sample, bool loop, int volume);
+void softMixerStop(int voice);
+void softMixerSetVolume(int volume); // of everything, 0..256
+
+// mixes the next frames; the SDL sink calls this from its own thread
+void softMixerRender(int16* out, int frames);
+
+struct SoftMixerStats {
+  uint64 frames; // mixed
+  uint64 voiceFrames; // summed from voices
+  uint64 ns; // spent mixing
+};
+void softMixerGetStats(SoftMixerStats* stats);
+
+#endif // SOFT_MIXER_H
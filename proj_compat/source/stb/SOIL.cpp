@@ -1956,9 +1956,14 @@ int query_NPOT_capability( void )
 	if( has_NPOT_capability == SOIL_CAPABILITY_UNKNOWN )
 	{
 		/*	we haven't yet checked for the capability, do so	*/
+		char const *extensions = (char const*)glGetString( GL_EXTENSIONS );
+		/*	desktop GL, or the GL ES flavours (clamped, no MIPmaps)	*/
 		if(
-			(NULL == strstr( (char const*)glGetString( GL_EXTENSIONS ),
-				"GL_ARB_texture_non_power_of_two" ) )
+			(NULL == extensions) ||
+			((NULL == strstr( extensions, "GL_ARB_texture_non_power_of_two" ) ) &&
+			(NULL == strstr( extensions, "GL_OES_texture_npot" ) ) &&
+			(NULL == strstr( extensions, "GL_APPLE_texture_2D_limited_npot" ) ) &&
+			(NULL == strstr( extensions, "GL_IMG_texture_npot" ) ))
 			)
 		{
 			/*	not there, flag the failure	*/
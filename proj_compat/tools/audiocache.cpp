@@ -0,0 +1,138 @@
+// audiocache - check the eviction order of the audio engine cache
+//
+// usage: audiocache [-q] sound_dir
+//
+// Loads the game's wav effects from sound_dir into the audio engine, plays
+// one of them to make it the most recently used, then tightens the byte
+// budget and loads one more sound past it. The sounds evicted to make room
+// have to be exactly the least recently used ones, which a plain LRU list
+// kept alongside predicts; every sound is then retrieved once to tell the
+// resident ones (a cache hit) from the evicted ones (a reload). Needs an
+// OpenAL device; with OpenAL Soft, ALSOFT_DRIVERS=null will do.
+// Returns non-zero on the first mismatch.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "audio_engine/audio.h"
+
+using namespace hoa_audio;
+
+static bool quiet = false;
+
+struct Entry {
+  std::string name;
+  uint32 size;
+  bool resident;
+};
+
+// oldest first, as the engine should see them
+static std::vector<Entry> _lru;
+
+static int _fail(const char *what, const std::string &name) {
+  fprintf(stderr, "audiocache: %s: %s\n", what, name.c_str());
+  return 1;
+}
+
+static void _touch(const std::string &name) {
+  for (size_t i = 0; i < _lru.size(); ++i)
+    if (_lru[i].name == name) {
+      Entry e = _lru[i];
+      _lru.erase(_lru.begin() + i);
+      _lru.push_back(e);
+      return;
+    }
+}
+
+// what the engine should drop to fit the budget, keeping the newest entry
+static uint32 _evict(uint32 resident, uint32 budget) {
+  uint32 evicted = 0;
+  for (size_t i = 0; i + 1 < _lru.size() && resident > budget; ++i) {
+    if (!_lru[i].resident)
+      continue;
+    _lru[i].resident = false;
+    resident -= _lru[i].size;
+    ++evicted;
+  }
+  return evicted;
+}
+
+static int _load(const std::string &dir, const char *name) {
+  std::string path = dir + "/" + name;
+  uint32 before = AudioManager->GetCacheStats().resident_bytes;
+  if (!AudioManager->LoadSound(path))
+    return _fail("could not load", path);
+  Entry e;
+  e.name = path;
+  e.size = AudioManager->GetCacheStats().resident_bytes - before;
+  e.resident = true;
+  _lru.push_back(e);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int a = 1;
+  if (a < argc && !strcmp(argv[a], "-q")) { quiet = true; ++a; }
+  if (a + 1 != argc) {
+    fprintf(stderr, "usage: audiocache [-q] sound_dir\n");
+    return 2;
+  }
+  std::string dir = argv[a];
+
+  AudioManager = AudioEngine::SingletonCreate();
+  if (!AudioManager->SingletonInitialize()) {
+    fprintf(stderr, "audiocache: no audio device\n");
+    return 1;
+  }
+  AudioManager->SetCacheBudget(0xffffffff);
+
+  static const char *first[] = { "door.wav", "key_move.wav", "click.wav", "map_locked.wav", "restart_level.wav" };
+  for (size_t i = 0; i < sizeof(first) / sizeof(first[0]); ++i)
+    if (_load(dir, first[i]))
+      return 1;
+
+  // the first one loaded is now the last one to go
+  AudioManager->PlaySound(_lru[0].name);
+  AudioManager->StopSound(_lru[0].name);
+  _touch(_lru[0].name);
+
+  // everything fits as it is, the next sound has to push the oldest out
+  AudioCacheStats stats = AudioManager->GetCacheStats();
+  uint32 budget = stats.resident_bytes;
+  AudioManager->SetCacheBudget(budget);
+  if (AudioManager->GetCacheStats().evictions != stats.evictions)
+    return _fail("evicted without a load", "budget");
+  if (_load(dir, "open_chest.wav"))
+    return 1;
+  uint32 expected = _evict(stats.resident_bytes + _lru.back().size, budget);
+
+  stats = AudioManager->GetCacheStats();
+  if (expected == 0 || stats.evictions != expected) {
+    fprintf(stderr, "audiocache: %u evictions, expected %u\n", stats.evictions, expected);
+    return 1;
+  }
+  if (stats.resident_bytes > budget)
+    return _fail("over budget", "open_chest.wav");
+
+  // hits don't move anything, so check every resident one before reloading any
+  for (int pass = 0; pass < 2; ++pass)
+    for (size_t i = 0; i < _lru.size(); ++i) {
+      if (_lru[i].resident != (pass == 0))
+        continue;
+      AudioCacheStats before = AudioManager->GetCacheStats();
+      if (AudioManager->RetrieveSound(_lru[i].name) == NULL)
+        return _fail("lost", _lru[i].name);
+      AudioCacheStats after = AudioManager->GetCacheStats();
+      bool hit = after.hits == before.hits + 1 && after.misses == before.misses;
+      if (hit != _lru[i].resident)
+        return _fail(hit ? "kept, should have been evicted" : "evicted, should have been kept", _lru[i].name);
+      if (!quiet)
+        printf("%-40s %7u bytes  %s\n", _lru[i].name.c_str(), _lru[i].size, hit ? "kept" : "evicted");
+    }
+
+  if (!quiet)
+    printf("%u of %u sounds evicted within a %u byte budget\n", expected, (uint32)_lru.size(), budget);
+  AudioEngine::SingletonDestroy();
+  return 0;
+}
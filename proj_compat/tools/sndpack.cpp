@@ -0,0 +1,196 @@
+// sndpack - pack the raw sound effects into one sound bank
+//
+// usage: sndpack [-q] -o sounds.bank sound.raw ... [-pcm sound.raw ...]
+//
+// Every .raw (16 bit mono at 44.1 kHz, as the game has always used) goes
+// in under its file name, IMA ADPCM coded; the ones after -pcm are kept
+// as they are, for sounds too noisy to survive 4 bits a sample. Each block
+// of samples starts from its own predictor and the encoder tries every
+// starting step for it, keeping the one closest to the source. The format
+// is in source/sound_bank.h, which also decodes it at run time.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#define SOUND_BANK_TOOL
+#include "sound_bank.h"
+
+static bool quiet = false;
+
+static const int _steps[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+  12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+static const int _moves[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+// one sample: picks the code and moves the state the way the decoder will
+static int _encodeSample(int sample, int &predictor, int &step) {
+  int s = _steps[step];
+  int diff = sample - predictor;
+  int code = 0;
+  if (diff < 0) { code = 8; diff = -diff; }
+  int delta = s >> 3;
+  if (diff >= s) { code |= 4; diff -= s; delta += s; }
+  if (diff >= s >> 1) { code |= 2; diff -= s >> 1; delta += s >> 1; }
+  if (diff >= s >> 2) { code |= 1; delta += s >> 2; }
+  predictor += (code & 8) ? -delta : delta;
+  if (predictor > 32767) predictor = 32767;
+  else if (predictor < -32768) predictor = -32768;
+  step += _moves[code & 7];
+  if (step < 0) step = 0;
+  else if (step > 88) step = 88;
+  return code;
+}
+
+// returns the squared error, fills out when given
+static double _encodeBlock(const short *samples, int count, int firstStep, unsigned char *out) {
+  int predictor = samples[0], step = firstStep;
+  double err = 0;
+  if (out) {
+    memset(out, 0, SOUND_BANK_BLOCK_SIZE);
+    out[0] = (unsigned char)predictor;
+    out[1] = (unsigned char)(predictor >> 8);
+    out[2] = (unsigned char)step;
+  }
+  for (int i = 0; i < count; i++) {
+    int code = _encodeSample(samples[i], predictor, step);
+    double d = samples[i] - predictor;
+    err += d*d;
+    if (out)
+      out[4 + i/2] |= code << ((i & 1) * 4);
+  }
+  return err;
+}
+
+struct _Sound {
+  std::string name;
+  std::vector<short> samples;
+  std::vector<unsigned char> data;
+  unsigned int format;
+};
+
+static std::string _basename(const char *path) {
+  const char *slash = strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+static bool _read(const char *path, _Sound &sound) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    fprintf(stderr, "*** sndpack: cannot read %s\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long bytes = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  sound.samples.resize(bytes / 2);
+  bool ok = sound.samples.empty() || fread(&sound.samples[0], 2, sound.samples.size(), f) == sound.samples.size();
+  fclose(f);
+  if (!ok)
+    fprintf(stderr, "*** sndpack: cannot read %s\n", path);
+  sound.name = _basename(path);
+  if (sound.name.size() >= SOUND_BANK_NAME_SIZE) {
+    fprintf(stderr, "*** sndpack: name too long: %s\n", sound.name.c_str());
+    return false;
+  }
+  return ok;
+}
+
+static void _encode(_Sound &sound, bool pcm) {
+  int count = (int)sound.samples.size();
+  if (pcm) {
+    sound.format = SOUND_BANK_PCM;
+    sound.data.resize(count * 2);
+    if (count)
+      memcpy(&sound.data[0], &sound.samples[0], count * 2);
+    return;
+  }
+  sound.format = SOUND_BANK_IMA_ADPCM;
+  int blocks = (count + SOUND_BANK_BLOCK_SAMPLES - 1) / SOUND_BANK_BLOCK_SAMPLES;
+  sound.data.resize(blocks * SOUND_BANK_BLOCK_SIZE);
+  double err = 0, signal = 0;
+  for (int b = 0; b < blocks; b++) {
+    const short *samples = &sound.samples[b * SOUND_BANK_BLOCK_SAMPLES];
+    int n = count - b * SOUND_BANK_BLOCK_SAMPLES;
+    if (n > SOUND_BANK_BLOCK_SAMPLES) n = SOUND_BANK_BLOCK_SAMPLES;
+    int best = 0;
+    double bestErr = -1;
+    for (int step = 0; step <= 88; step++) {
+      double e = _encodeBlock(samples, n, step, NULL);
+      if (bestErr < 0 || e < bestErr) { bestErr = e; best = step; }
+    }
+    err += _encodeBlock(samples, n, best, &sound.data[b * SOUND_BANK_BLOCK_SIZE]);
+    for (int i = 0; i < n; i++)
+      signal += (double)samples[i] * samples[i];
+  }
+  if (!quiet)
+    printf("** %s: %d samples, %u bytes (was %d), %.1f dB SNR\n", sound.name.c_str(), count,
+	   (unsigned)sound.data.size(), count * 2, err > 0 ? 10 * log10(signal / err) : 99.0);
+}
+
+static void _put32(std::vector<unsigned char> &out, size_t at, unsigned int v) {
+  for (int i = 0; i < 4; i++)
+    out[at + i] = (unsigned char)(v >> (i * 8));
+}
+
+static bool _write(const char *path, std::vector<_Sound> &sounds) {
+  // header and entries, then the data 4 byte aligned
+  size_t at = sizeof(SoundBankHeader) + sounds.size() * sizeof(SoundBankEntry);
+  std::vector<unsigned char> out(at, 0);
+  _put32(out, 0, SOUND_BANK_MAGIC);
+  _put32(out, 4, SOUND_BANK_VERSION);
+  _put32(out, 8, (unsigned)sounds.size());
+  _put32(out, 12, 44100);
+  for (size_t i = 0; i < sounds.size(); i++) {
+    size_t e = sizeof(SoundBankHeader) + i * sizeof(SoundBankEntry);
+    memcpy(&out[e], sounds[i].name.c_str(), sounds[i].name.size());
+    _put32(out, e + SOUND_BANK_NAME_SIZE, sounds[i].format);
+    _put32(out, e + SOUND_BANK_NAME_SIZE + 4, (unsigned)sounds[i].samples.size());
+    _put32(out, e + SOUND_BANK_NAME_SIZE + 8, (unsigned)out.size());
+    _put32(out, e + SOUND_BANK_NAME_SIZE + 12, (unsigned)sounds[i].data.size());
+    out.insert(out.end(), sounds[i].data.begin(), sounds[i].data.end());
+    out.resize((out.size() + 3) & ~3, 0);
+  }
+  FILE *f = fopen(path, "wb");
+  if (f == NULL || fwrite(&out[0], 1, out.size(), f) != out.size()) {
+    fprintf(stderr, "*** sndpack: cannot write %s\n", path);
+    if (f) fclose(f);
+    return false;
+  }
+  fclose(f);
+  if (!quiet)
+    printf("** %s: %u sounds, %u bytes\n", path, (unsigned)sounds.size(), (unsigned)out.size());
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  const char *output = NULL;
+  bool pcm = false;
+  std::vector<_Sound> sounds;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-q") == 0)
+      quiet = true;
+    else if (strcmp(argv[i], "-pcm") == 0)
+      pcm = true;
+    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      output = argv[++i];
+    else {
+      sounds.push_back(_Sound());
+      if (!_read(argv[i], sounds.back()))
+	return 1;
+      _encode(sounds.back(), pcm);
+    }
+  }
+  if (output == NULL || sounds.empty()) {
+    fprintf(stderr, "usage: sndpack [-q] -o sounds.bank sound.raw ... [-pcm sound.raw ...]\n");
+    return 1;
+  }
+  return _write(output, sounds) ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+// texconv - precompress game textures for the compat backend
+//
+// usage: texconv [-q] image.png ...
+//
+// Writes image.dds (DXT1 when opaque, DXT5 otherwise) and, for opaque
+// images, image.pkm (ETC1) next to each png. Pixels are premultiplied
+// like the runtime does for pngs and padded to a power of two; the real
+// image size is kept in the header (dwReserved1 of the DDS, the original
+// size fields of the PKM), so CcIw2DImage can set the texture coordinates.
+// The runtime picks whichever of the two the GL can sample and falls back
+// to the png otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "stb/stb_image.h"
+#include "stb/image_DXT.h"
+
+#define DDS_SKEY 0x59454b53 // "SKEY"
+
+static bool quiet = false;
+
+static int _pot(int v) { int p = 4; while (p < v) p <<= 1; return p; }
+
+static std::string _sibling(const char *png, const char *ext) {
+  std::string path = png;
+  size_t dot = path.rfind('.');
+  if (dot != std::string::npos && path.find('/', dot) == std::string::npos)
+    path.erase(dot);
+  return path + ext;
+}
+
+// ----- ETC1 -----
+
+static const int _etc1_modifiers[8][4] = {
+  {2, 8, -2, -8}, {5, 17, -5, -17}, {9, 29, -9, -29}, {13, 42, -13, -42},
+  {18, 60, -18, -60}, {24, 80, -24, -80}, {33, 106, -33, -106}, {47, 183, -47, -183}
+};
+
+static inline int _clamp(int v) { return v < 0 ? 0 : (v > 255 ? 255 : v); }
+
+// best table for one half of a block, fills the 2 bit selectors
+static int _etc1Half(const unsigned char *block, const int *pixels, const int base[3], int &table, int selectors[16]) {
+  int best = -1;
+  for (int t = 0; t < 8; t++) {
+    int err = 0, sel[8];
+    for (int i = 0; i < 8; i++) {
+      const unsigned char *p = block + pixels[i]*4;
+      int pixelBest = -1;
+      for (int m = 0; m < 4; m++) {
+	int e = 0;
+	for (int c = 0; c < 3; c++) {
+	  int d = _clamp(base[c] + _etc1_modifiers[t][m]) - p[c];
+	  e += d*d;
+	}
+	if (pixelBest < 0 || e < pixelBest) { pixelBest = e; sel[i] = m; }
+      }
+      err += pixelBest;
+    }
+    if (best < 0 || err < best) {
+      best = err; table = t;
+      for (int i = 0; i < 8; i++) selectors[pixels[i]] = sel[i];
+    }
+  }
+  return best;
+}
+
+// block is 4x4 rgba, pixel p = x*4+y as ETC1 orders them
+static void _etc1Block(const unsigned char *block, unsigned char out[8]) {
+  unsigned long long bestBits = 0;
+  int bestErr = -1;
+  for (int flip = 0; flip < 2; flip++) {
+    int halves[2][8];
+    int n[2] = {0, 0};
+    for (int x = 0; x < 4; x++)
+      for (int y = 0; y < 4; y++) {
+	int h = flip ? (y >= 2) : (x >= 2);
+	halves[h][n[h]++] = x*4+y;
+      }
+    float avg[2][3];
+    for (int h = 0; h < 2; h++)
+      for (int c = 0; c < 3; c++) {
+	int sum = 0;
+	for (int i = 0; i < 8; i++) sum += block[halves[h][i]*4+c];
+	avg[h][c] = sum / 8.0f;
+      }
+    // differential when the two colours are close enough, individual otherwise
+    int q[2][3], base[2][3];
+    bool diff = true;
+    for (int c = 0; c < 3; c++) {
+      q[0][c] = (int)(avg[0][c]*31/255 + 0.5f);
+      q[1][c] = (int)(avg[1][c]*31/255 + 0.5f);
+      int d = q[1][c] - q[0][c];
+      if (d < -4 || d > 3) diff = false;
+    }
+    for (int h = 0; h < 2; h++)
+      for (int c = 0; c < 3; c++) {
+	if (diff) {
+	  base[h][c] = (q[h][c] << 3) | (q[h][c] >> 2);
+	} else {
+	  q[h][c] = (int)(avg[h][c]*15/255 + 0.5f);
+	  base[h][c] = (q[h][c] << 4) | q[h][c];
+	}
+      }
+    int tables[2], selectors[16];
+    int err = _etc1Half(block, halves[0], base[0], tables[0], selectors) + _etc1Half(block, halves[1], base[1], tables[1], selectors);
+    if (bestErr >= 0 && err >= bestErr)
+      continue;
+    bestErr = err;
+    unsigned long long bits = 0;
+    for (int c = 0; c < 3; c++) {
+      int shift = 59 - c*8;
+      if (diff)
+	bits |= ((unsigned long long)q[0][c] << shift) | ((unsigned long long)((q[1][c]-q[0][c]) & 7) << (shift-3));
+      else
+	bits |= ((unsigned long long)q[0][c] << (shift+1)) | ((unsigned long long)q[1][c] << (shift-3));
+    }
+    bits |= (unsigned long long)tables[0] << 37 | (unsigned long long)tables[1] << 34;
+    bits |= (unsigned long long)diff << 33 | (unsigned long long)flip << 32;
+    for (int p = 0; p < 16; p++) {
+      // the selector's high bit goes to the upper half word
+      int s = selectors[p];
+      bits |= (unsigned long long)(s >> 1) << (16+p) | (unsigned long long)(s & 1) << p;
+    }
+    bestBits = bits;
+  }
+  for (int i = 0; i < 8; i++)
+    out[i] = (unsigned char)(bestBits >> (56 - i*8));
+}
+
+static bool _writePKM(const char *path, const unsigned char *rgba, int width, int height, int imageWidth, int imageHeight) {
+  FILE *f = fopen(path, "wb");
+  if (f == NULL)
+    return false;
+  unsigned char header[16] = { 'P', 'K', 'M', ' ', '1', '0', 0, 0,
+    (unsigned char)(width >> 8), (unsigned char)width, (unsigned char)(height >> 8), (unsigned char)height,
+    (unsigned char)(imageWidth >> 8), (unsigned char)imageWidth, (unsigned char)(imageHeight >> 8), (unsigned char)imageHeight };
+  fwrite(header, 1, sizeof(header), f);
+  for (int by = 0; by < height; by += 4)
+    for (int bx = 0; bx < width; bx += 4) {
+      unsigned char block[16*4], out[8];
+      for (int x = 0; x < 4; x++)
+	for (int y = 0; y < 4; y++)
+	  memcpy(block + (x*4+y)*4, rgba + ((by+y)*width + bx+x)*4, 4);
+      _etc1Block(block, out);
+      fwrite(out, 1, sizeof(out), f);
+    }
+  fclose(f);
+  return true;
+}
+
+// ----- DDS -----
+
+static bool _writeDDS(const char *path, const unsigned char *rgba, int width, int height, int imageWidth, int imageHeight, bool opaque) {
+  int channels = opaque ? 3 : 4;
+  unsigned char *pixels = (unsigned char*)malloc(width*height*channels);
+  for (int i = 0; i < width*height; i++)
+    memcpy(pixels + i*channels, rgba + i*4, channels);
+  int ok = save_image_as_DDS(path, width, height, channels, pixels);
+  free(pixels);
+  if (!ok)
+    return false;
+  // the image size goes in the reserved words after the mipmap count
+  FILE *f = fopen(path, "r+b");
+  if (f == NULL)
+    return false;
+  unsigned int reserved[3] = { DDS_SKEY, (unsigned int)imageWidth, (unsigned int)imageHeight };
+  fseek(f, 32, SEEK_SET);
+  fwrite(reserved, sizeof(unsigned int), 3, f);
+  fclose(f);
+  return true;
+}
+
+static bool _convert(const char *png) {
+  int imageWidth, imageHeight, channels;
+  unsigned char *image = stbi_load(png, &imageWidth, &imageHeight, &channels, 4);
+  if (image == NULL) {
+    fprintf(stderr, "*** texconv: cannot read %s (%s)\n", png, stbi_failure_reason());
+    return false;
+  }
+
+  // premultiplied and padded with transparent black
+  int width = _pot(imageWidth), height = _pot(imageHeight);
+  unsigned char *rgba = (unsigned char*)calloc(width*height, 4);
+  bool opaque = true;
+  for (int y = 0; y < imageHeight; y++)
+    for (int x = 0; x < imageWidth; x++) {
+      const unsigned char *s = image + (y*imageWidth + x)*4;
+      unsigned char *d = rgba + (y*width + x)*4;
+      for (int c = 0; c < 3; c++)
+	d[c] = (unsigned char)((s[c]*s[3] + 127) / 255);
+      d[3] = s[3];
+      if (s[3] != 255) opaque = false;
+    }
+  stbi_image_free(image);
+
+  size_t rgbaBytes = (size_t)width*height*(opaque ? 3 : 4);
+  std::string dds = _sibling(png, ".dds");
+  bool ok = _writeDDS(dds.c_str(), rgba, width, height, imageWidth, imageHeight, opaque);
+  if (ok && !quiet)
+    printf("** %s: %dx%d in %dx%d, %s %u bytes (was %u)\n", dds.c_str(), imageWidth, imageHeight, width, height,
+	   opaque ? "DXT1" : "DXT5", (unsigned)(width*height/(opaque ? 2 : 1)), (unsigned)rgbaBytes);
+  // ETC1 has no alpha
+  if (ok && opaque) {
+    std::string pkm = _sibling(png, ".pkm");
+    ok = _writePKM(pkm.c_str(), rgba, width, height, imageWidth, imageHeight);
+    if (ok && !quiet)
+      printf("** %s: %dx%d in %dx%d, ETC1 %u bytes (was %u)\n", pkm.c_str(), imageWidth, imageHeight, width, height,
+	     (unsigned)(width*height/2), (unsigned)rgbaBytes);
+  }
+  free(rgba);
+  if (!ok)
+    fprintf(stderr, "*** texconv: cannot write the textures for %s\n", png);
+  return ok;
+}
+
+int main(int argc, char *argv[]) {
+  int failed = 0, files = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-q") == 0) {
+      quiet = true;
+      continue;
+    }
+    files++;
+    if (!_convert(argv[i]))
+      failed++;
+  }
+  if (files == 0) {
+    fprintf(stderr, "usage: texconv [-q] image.png ...\n");
+    return 1;
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/bash
+# the compat build streams music as ogg, made here from the mp3s Marmalade plays
+for f in menu.mp3 gameplay1.mp3 gameplay2.mp3 gameplay3.mp3; do
+	echo "** converting $f ..."
+	if which ffmpeg > /dev/null; then
+		ffmpeg -v error -y -i $f -map_metadata -1 -c:a libvorbis -q:a 4 ${f%.mp3}.ogg
+	else
+		mpg123 -q -w - $f | oggenc -Q -q 4 -o ${f%.mp3}.ogg -
+	fi
+done
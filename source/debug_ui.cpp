@@ -2,7 +2,7 @@
 #include "debug_ui.h"
 #include "ig2d/ig_distorter.h"
 
-#ifdef DEUG_UI
+#ifdef DEBUG_UI
 
 #include "Turs2DebugPanel.h"
 
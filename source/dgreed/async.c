@@ -5,6 +5,7 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <unistd.h>
 
 static bool async_initialized = false;
 
@@ -13,34 +14,81 @@ static pthread_mutex_t critical_sections[MAX_CRITICAL_SECTIONS];
 static uint n_critical_sections = 4; // Critical sections 0..3 are used for async system
 
 #define ASYNC_MKCS_CS 0
-#define ASYNC_TASK_STATE_CS 1
 #define ASYNC_SCHED_CS 2
 #define ASYNC_THREAD_CS 3
 
 #define THREAD_NAME_LEN 8
-#define MAX_THREADS 4
-#define ASYNC_THREADS 1
-#define IO_THREAD 0
-
-typedef struct {
+#define MAX_WORKERS 8
+#define MAX_THREADS (MAX_WORKERS + 1)
+#define DEQUE_SIZE 4096 // Power of two
+#define TASK_CHUNK_SIZE 256
+
+// TaskId is a record slot in the low bits and its generation in the rest
+#define TASK_SLOT_BITS 20
+#define TASK_SLOT_MASK ((1 << TASK_SLOT_BITS) - 1)
+#define TASK_GEN_MASK (~0U >> TASK_SLOT_BITS)
+#define MAX_TASK_CHUNKS ((1 << TASK_SLOT_BITS) / TASK_CHUNK_SIZE)
+
+// Timer wheel: WHEEL_LEVELS wheels of WHEEL_SIZE slots, each slot of a
+// level spans a whole turn of the level below
+#define WHEEL_TICK_MS 16
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
+#define WHEEL_SPAN (1U << (WHEEL_BITS * WHEEL_LEVELS))
+
+// Task record. Records are allocated in chunks which never move, so
+// pointers to them stay valid forever and a TaskId can always be turned
+// back into its record.
+typedef struct TaskRecord {
 	Task task;
-	TaskId id;
 	void* userdata;
+	TaskId id;
+	uint slot;
+	// Bumped when the task finishes, ids of older generations are done
+	volatile uint gen;
+	struct TaskRecord* parent;
+	// The task itself plus its unfinished children
+	volatile int pending;
+	// In io queue, injection queue, timer wheel or free list
 	ListHead list;
-} TaskDef;
+	// Scheduler tick a scheduled task is due at
+	uint due;
+	bool scheduled;
+	// In the stack of finished records not yet back in the free list
+	struct TaskRecord* returned;
+} TaskRecord;
+
+// Task waiting to run on the main thread once another one is finished
+typedef struct {
+	TaskId after;
+	Task task;
+	void* userdata;
+} Continuation;
 
+// Chase-Lev work stealing deque. Only the owner pushes and pops at the
+// bottom, other workers steal from the top.
+typedef struct {
+	volatile long top;
+	volatile long bottom;
+	TaskRecord* volatile tasks[DEQUE_SIZE];
+} TaskDeque;
+
+// Mutex protected queue, for the in-order io thread and for tasks
+// submitted from threads without a deque of their own
 typedef struct {
 	ListHead queue;
 	pthread_cond_t cond;
 	pthread_mutex_t mutex;
-	int count;
+	volatile int count;
 } TaskQueue;
 
 typedef struct {
 	char name[THREAD_NAME_LEN];
 	bool alive;
 	pthread_t thread;
-	TaskQueue* tq;
+	TaskDeque* deque; // NULL for io thread
+	uint index;
 } WorkerThread;
 
 static bool async_threads_created;
@@ -48,15 +96,18 @@ static bool io_thread_created;
 
 static WorkerThread threads[MAX_THREADS];
 static uint n_threads;
+static uint n_workers;
+static volatile bool workers_quit;
+
+// Worker thread of the calling thread, task record being run by it
+static pthread_key_t thread_worker_key;
+static pthread_key_t thread_task_key;
 
-static void _async_init_task_state(void);
-static void _async_close_task_state(void);
 static void _async_init_queues(void);
 static void _async_close_queues(void);
 static void _async_stop_queues(void);
 static void _async_init_scheduler(void);
 static void _async_close_scheduler(void);
-void async_process_schedule(void);
 
 static void _check_async_threads(void);
 static void _check_io_thread(void);
@@ -79,10 +130,12 @@ void async_init(void) {
 	async_initialized = true;
 
 	n_threads = 0;
+	n_workers = 0;
 	async_threads_created = false;
 	io_thread_created = false;
+	pthread_key_create(&thread_worker_key, NULL);
+	pthread_key_create(&thread_task_key, NULL);
 
-	_async_init_task_state();
 	_async_init_queues();
 	_async_init_scheduler();
 }
@@ -94,7 +147,9 @@ void async_close(void) {
 
 	_async_close_scheduler();
 	_async_close_queues();
-	_async_close_task_state();
+
+	pthread_key_delete(thread_worker_key);
+	pthread_key_delete(thread_task_key);
 
 	uint i; for(i = 0; i > MAX_CRITICAL_SECTIONS; ++i) {
 		pthread_mutex_destroy(&critical_sections[i]);
@@ -150,128 +205,140 @@ void async_leave_cs(CriticalSection cs) {
 #endif
 }
 
-// Task state tracking
-
-bool async_task_state_initialized = false;
-TaskId async_next_taskid = 1;
-TaskId async_highest_finished_taskid = 0;
-TaskId async_lowest_unfinished_taskid = 0;
-AATree async_unfinished_taskids;
-
-static void _async_init_task_state(void) {
-	assert(async_initialized);
-
-	async_enter_cs(ASYNC_TASK_STATE_CS);
+// Task records
 
-	assert(!async_task_state_initialized);
+static pthread_mutex_t taskrec_mutex;
+static ListHead taskrec_free;
+static TaskRecord* volatile taskrec_returned;
+static TaskRecord* volatile taskrec_chunks[MAX_TASK_CHUNKS];
+static volatile uint taskrec_n_chunks;
 
-	aatree_init(&async_unfinished_taskids);
-	async_task_state_initialized = true;
-
-	async_leave_cs(ASYNC_TASK_STATE_CS);
+static void _async_init_task_records(void) {
+	pthread_mutex_init(&taskrec_mutex, NULL);
+	list_init(&taskrec_free);
+	taskrec_returned = NULL;
+	taskrec_n_chunks = 0;
 }
 
-static void _async_close_task_state(void) {
-	assert(async_initialized);
-
-	async_enter_cs(ASYNC_TASK_STATE_CS);
-
-	assert(async_task_state_initialized);
-
-	if(aatree_size(&async_unfinished_taskids) != 0)
-		LOG_WARNING("Closing task state tracker with unfinished tasks!");
-
-	aatree_free(&async_unfinished_taskids);
-	async_task_state_initialized = false;
-
-	async_leave_cs(ASYNC_TASK_STATE_CS);
+static void _async_close_task_records(void) {
+	uint unfinished = 0;
+	uint i; for(i = 0; i < taskrec_n_chunks; ++i) {
+		uint j; for(j = 0; j < TASK_CHUNK_SIZE; ++j)
+			unfinished += taskrec_chunks[i][j].pending ? 1 : 0;
+		MEM_FREE(taskrec_chunks[i]);
+	}
+	if(unfinished)
+		LOG_WARNING("Closing task records with unfinished tasks!");
+	taskrec_n_chunks = 0;
+	pthread_mutex_destroy(&taskrec_mutex);
 }
 
-static TaskId _async_new_taskid(void) {
-	assert(async_initialized);
-
-	async_enter_cs(ASYNC_TASK_STATE_CS);
-
-	assert(async_task_state_initialized);
-	TaskId result = async_next_taskid++;
-	aatree_insert(&async_unfinished_taskids, result, (void*)1);
+static void _async_new_task_chunk(void) {
+	if(taskrec_n_chunks == MAX_TASK_CHUNKS)
+		LOG_ERROR("Too many unfinished tasks");
+
+	uint n = taskrec_n_chunks;
+	TaskRecord* chunk = MEM_ALLOC(sizeof(TaskRecord) * TASK_CHUNK_SIZE);
+	uint i; for(i = 0; i < TASK_CHUNK_SIZE; ++i) {
+		chunk[i].slot = n * TASK_CHUNK_SIZE + i;
+		chunk[i].gen = 1;
+		chunk[i].pending = 0;
+		list_push_back(&taskrec_free, &chunk[i].list);
+	}
 
-	async_leave_cs(ASYNC_TASK_STATE_CS);
-	return result;
+	// Readers index chunks without the lock, publish it only when complete
+	taskrec_chunks[n] = chunk;
+	__sync_synchronize();
+	taskrec_n_chunks = n + 1;
 }
 
-static void _async_finish_taskid(TaskId id) {
-	assert(async_initialized);
-
-	async_enter_cs(ASYNC_TASK_STATE_CS);
-
-	assert(async_task_state_initialized);
-	assert(id < async_next_taskid);
-	assert(id >= async_lowest_unfinished_taskid);
-
-	// Remove id from unfinished taskids list
-	void* p = aatree_remove(&async_unfinished_taskids, id);
-	assert(p);
-	p = 0; // Prevent unused warning
-
-	// Update highest finished taskid
-	async_highest_finished_taskid = MAX(async_highest_finished_taskid, id);
-
-	// If id was the previous lowest unfinished taskid, find a new one.
-	// Also find a new one if lowest unfinished taskid is 0 (means previously
-	// there were no unfinished tasks).
-	if(	id == async_lowest_unfinished_taskid ||
-		0 == async_lowest_unfinished_taskid) {
-
-		uint n_unfinished_tasks = aatree_size(&async_unfinished_taskids);
-
-		// If no tasks are unfinished, set lowest taskid to 0
-		if(0 == n_unfinished_tasks) {
-			async_lowest_unfinished_taskid = 0;
-		}
-		else {
-			async_lowest_unfinished_taskid =
-				aatree_min(&async_unfinished_taskids, NULL);
-		}
+static TaskRecord* _async_alloc_task(Task task, void* userdata) {
+	pthread_mutex_lock(&taskrec_mutex);
+	if(list_empty(&taskrec_free)) {
+		// Take all the finished records at once, popping them one by one
+		// would open the door to ABA
+		TaskRecord* rec;
+		do {
+			rec = taskrec_returned;
+		} while(rec && !__sync_bool_compare_and_swap(&taskrec_returned, rec, NULL));
+
+		for(; rec; rec = rec->returned)
+			list_push_back(&taskrec_free, &rec->list);
 	}
+	if(list_empty(&taskrec_free))
+		_async_new_task_chunk();
+
+	// Oldest free record first, so a slot takes long to come around to
+	// the same generation again
+	TaskRecord* rec = list_entry(list_pop_front(&taskrec_free), TaskRecord, list);
+	pthread_mutex_unlock(&taskrec_mutex);
+
+	rec->task = task;
+	rec->userdata = userdata;
+	rec->id = (rec->gen << TASK_SLOT_BITS) | rec->slot;
+	rec->parent = NULL;
+	rec->pending = 1;
+	rec->scheduled = false;
+	return rec;
+}
 
-	async_leave_cs(ASYNC_TASK_STATE_CS);
+// Marks the task finished and returns its record, without locking
+static void _async_finish_task(TaskRecord* rec) {
+	uint gen = (rec->gen + 1) & TASK_GEN_MASK;
+	// Everything the task did is visible before it counts as finished
+	__sync_synchronize();
+	rec->gen = gen ? gen : 1;
+
+	TaskRecord* head;
+	do {
+		head = taskrec_returned;
+		rec->returned = head;
+	} while(!__sync_bool_compare_and_swap(&taskrec_returned, head, rec));
 }
 
 bool async_is_finished(TaskId id) {
 	assert(async_initialized);
 
-	bool result;
+	uint slot = id & TASK_SLOT_MASK;
+	assert(slot / TASK_CHUNK_SIZE < taskrec_n_chunks);
 
-	async_enter_cs(ASYNC_TASK_STATE_CS);
-	assert(async_task_state_initialized);
-	assert(id < async_next_taskid);
-
-	if(id < async_lowest_unfinished_taskid) {
-		result = true;
-	}
-	else if(id > async_highest_finished_taskid) {
-		result = false;
-	}
-	else {
-		// We need to check if taskid id is in unfinished set
-		void* p = aatree_find(&async_unfinished_taskids, id);
-		result = (p == NULL);
-	}
+	TaskRecord* rec = &taskrec_chunks[slot / TASK_CHUNK_SIZE][slot % TASK_CHUNK_SIZE];
+	if(rec->gen == (id >> TASK_SLOT_BITS))
+		return false;
 
-	async_leave_cs(ASYNC_TASK_STATE_CS);
+	// Pairs with the barrier in _async_finish_task
+	__sync_synchronize();
+	return true;
+}
 
-	return result;
+// Called when the task or one of its children is done. The last one
+// marks the task finished and in turn releases the parent.
+static void _async_release_task(TaskRecord* rec) {
+	while(rec && __sync_sub_and_fetch(&rec->pending, 1) == 0) {
+		TaskRecord* parent = rec->parent;
+		_async_finish_task(rec);
+		rec = parent;
+	}
 }
 
+static void _async_execute(TaskRecord* rec) {
+	void* outer = pthread_getspecific(thread_task_key);
+	pthread_setspecific(thread_task_key, rec);
+	(*rec->task)(rec->userdata);
+	pthread_setspecific(thread_task_key, outer);
+	_async_release_task(rec);
+}
 
 // Task queues
 
-TaskQueue tq_async;
-TaskQueue tq_io;
+static TaskQueue tq_inject;
+static TaskQueue tq_io;
+static TaskDeque deques[MAX_WORKERS];
 
-DArray taskdef_pool;
-Heap taskdef_pool_freecells;
+// Workers without anything to do sleep here
+static pthread_mutex_t sleep_mutex;
+static pthread_cond_t sleep_cond;
+static volatile int n_sleeping;
 
 static void _async_init_task_queue(TaskQueue* tq) {
 	assert(tq);
@@ -284,19 +351,23 @@ static void _async_init_task_queue(TaskQueue* tq) {
 
 static void _async_close_task_queue(TaskQueue* tq) {
 	assert(tq);
-	assert(list_empty(&tq->queue));
-	assert(tq->count == -1 || tq->count == 0);
+
+	if(!list_empty(&tq->queue))
+		LOG_WARNING("Closing task queue with tasks that never ran!");
 
 	pthread_mutex_destroy(&tq->mutex);
 	pthread_cond_destroy(&tq->cond);
 }
 
 static void _async_init_queues(void) {
-	_async_init_task_queue(&tq_async);
+	_async_init_task_queue(&tq_inject);
 	_async_init_task_queue(&tq_io);
+	pthread_mutex_init(&sleep_mutex, NULL);
+	pthread_cond_init(&sleep_cond, NULL);
+	n_sleeping = 0;
+	workers_quit = false;
 
-	taskdef_pool = darray_create(sizeof(TaskDef), 0);
-	heap_init(&taskdef_pool_freecells);
+	_async_init_task_records();
 }
 
 static void _async_stop_queues(void) {
@@ -304,8 +375,7 @@ static void _async_stop_queues(void) {
 
 	async_enter_cs(ASYNC_THREAD_CS);
 
-	// Just set count to -1 and signal workers,
-	// they will quit
+	// Set the quit flags and wake everyone up, they will quit
 
 	if(io_thread_created) {
 		pthread_mutex_lock(&tq_io.mutex);
@@ -315,10 +385,10 @@ static void _async_stop_queues(void) {
 	}
 
 	if(async_threads_created) {
-		pthread_mutex_lock(&tq_async.mutex);
-		tq_async.count = -1;
-		pthread_mutex_unlock(&tq_async.mutex);
-		pthread_cond_broadcast(&tq_async.cond);
+		pthread_mutex_lock(&sleep_mutex);
+		workers_quit = true;
+		pthread_mutex_unlock(&sleep_mutex);
+		pthread_cond_broadcast(&sleep_cond);
 	}
 
 	// Join all threads
@@ -333,200 +403,362 @@ static void _async_stop_queues(void) {
 
 static void _async_close_queues(void) {
 	_async_close_task_queue(&tq_io);
-	_async_close_task_queue(&tq_async);
+	_async_close_task_queue(&tq_inject);
+	pthread_cond_destroy(&sleep_cond);
+	pthread_mutex_destroy(&sleep_mutex);
 
-	darray_free(&taskdef_pool);
-	heap_free(&taskdef_pool_freecells);
+	_async_close_task_records();
 }
 
-// If append to taskdef pool triggers realloc, all pointers inside lists
-// become invalid. Good news is that they all move by constant amount, so
-// just recalculate all pointers inside lists.
-static void _async_rebase_lists(ptrdiff_t delta) {
-	void* range_start = taskdef_pool.data - delta;
-	void* range_end = range_start + taskdef_pool.item_size * taskdef_pool.size;
-
-	void* prev;
-	void* next;
+static void _async_enqueue(TaskQueue* tq, TaskRecord* rec) {
+	pthread_mutex_lock(&tq->mutex);
+	list_push_back(&tq->queue, &rec->list);
+	tq->count++;
+	pthread_mutex_unlock(&tq->mutex);
+}
 
-	if(!list_empty(&tq_io.queue)) {
-		prev = (void*)tq_io.queue.prev;
-		next = (void*)tq_io.queue.next;
-		assert(range_start <= prev && prev < range_end);
-		assert(range_start <= next && next < range_end);
+static TaskRecord* _async_dequeue(TaskQueue* tq) {
+	// Unlocked peek, most of the time there is nothing
+	if(tq->count <= 0)
+		return NULL;
 
-		tq_io.queue.prev = (void*)(prev + delta);
-		tq_io.queue.next = (void*)(next + delta);
+	TaskRecord* rec = NULL;
+	pthread_mutex_lock(&tq->mutex);
+	if(tq->count > 0) {
+		rec = list_entry(list_pop_front(&tq->queue), TaskRecord, list);
+		tq->count--;
 	}
+	pthread_mutex_unlock(&tq->mutex);
+	return rec;
+}
+
+static bool _async_deque_push(TaskDeque* d, TaskRecord* rec) {
+	long b = d->bottom;
+	long t = d->top;
+	if(b - t >= DEQUE_SIZE)
+		return false;
+	d->tasks[b & (DEQUE_SIZE-1)] = rec;
+	// Task is in place before it becomes visible to thieves
+	__sync_synchronize();
+	d->bottom = b + 1;
+	return true;
+}
 
-	if(!list_empty(&tq_async.queue)) {
-		prev = (void*)tq_async.queue.prev;
-		next = (void*)tq_async.queue.next;
-		assert(range_start <= prev && prev < range_end);
-		assert(range_start <= next && next < range_end);
+static TaskRecord* _async_deque_pop(TaskDeque* d) {
+	long b = d->bottom - 1;
+	d->bottom = b;
+	__sync_synchronize();
+	long t = d->top;
 
-		tq_async.queue.prev = (void*)(prev + delta);
-		tq_async.queue.next = (void*)(next + delta);
+	if(t > b) {
+		// Empty
+		d->bottom = b + 1;
+		return NULL;
 	}
 
-	TaskDef* list_nodes = DARRAY_DATA_PTR(taskdef_pool, TaskDef);
-	uint i; for(i = 0; i < taskdef_pool.size; ++i) {
-		TaskDef* def = &list_nodes[i];
-		prev = (void*)def->list.prev;
-		next = (void*)def->list.next;
-		if(range_start <= prev && prev < range_end)
-			def->list.prev = (ListHead*)(prev + delta);
-		if(range_start <= next && next < range_end)
-			def->list.next = (ListHead*)(next + delta);
+	TaskRecord* rec = d->tasks[b & (DEQUE_SIZE-1)];
+	if(t == b) {
+		// Last task, race thieves for it
+		if(!__sync_bool_compare_and_swap(&d->top, t, t + 1))
+			rec = NULL;
+		d->bottom = b + 1;
 	}
+	return rec;
 }
 
-static void _async_enqueue(ListHead* head, Task task, TaskId id, void* userdata) {
-	assert(head);
-	assert(taskdef_pool.item_size == sizeof(TaskDef));
+static TaskRecord* _async_deque_steal(TaskDeque* d) {
+	long t = d->top;
+	__sync_synchronize();
+	long b = d->bottom;
 
-	uint i = ~0;
-	if(heap_size(&taskdef_pool_freecells) > 0) {
-		// We're lucky, there is a free cell
-		i = heap_pop(&taskdef_pool_freecells, NULL);
-	}
-	else {
-		// We have to append new cell, which might trigger realloc
-		void* old_data = taskdef_pool.data;
-		TaskDef dummy = {NULL, 0, NULL, {NULL, NULL}};
-		i = taskdef_pool.size;
-		darray_append(&taskdef_pool, &dummy);
-		void* new_data = taskdef_pool.data;
-		if(old_data != new_data)
-			_async_rebase_lists(new_data - old_data);
-	}
-	assert(i < taskdef_pool.size);
+	if(t >= b)
+		return NULL;
 
-	// Fill data and push taskdef to the list
-	TaskDef* defs = DARRAY_DATA_PTR(taskdef_pool, TaskDef);
-	TaskDef* new = &defs[i];
+	TaskRecord* rec = d->tasks[t & (DEQUE_SIZE-1)];
+	if(!__sync_bool_compare_and_swap(&d->top, t, t + 1))
+		return NULL; // Lost to the owner or another thief
+	return rec;
+}
 
-	new->task = task;
-	new->id = id;
-	new->userdata = userdata;
+static bool _async_work_available(void) {
+	if(tq_inject.count > 0)
+		return true;
+	uint i; for(i = 0; i < n_workers; ++i) {
+		if(deques[i].top < deques[i].bottom)
+			return true;
+	}
+	return false;
+}
 
-	list_push_back(head, &new->list);
+static void _async_wake_worker(void) {
+	// Pairs with the barrier in _async_sleep: either the sleeper sees the
+	// new task, or this sees the sleeper
+	__sync_synchronize();
+	if(n_sleeping > 0) {
+		pthread_mutex_lock(&sleep_mutex);
+		pthread_cond_signal(&sleep_cond);
+		pthread_mutex_unlock(&sleep_mutex);
+	}
 }
 
-static bool _async_dequeue(ListHead* head, TaskDef* dest) {
-	if(list_empty(head))
-		return false;
+// Returns false when the worker should quit
+static bool _async_sleep(void) {
+	pthread_mutex_lock(&sleep_mutex);
+	__sync_fetch_and_add(&n_sleeping, 1);
+	__sync_synchronize();
+	if(!workers_quit && !_async_work_available())
+		pthread_cond_wait(&sleep_cond, &sleep_mutex);
+	__sync_fetch_and_sub(&n_sleeping, 1);
+	bool quit = workers_quit;
+	pthread_mutex_unlock(&sleep_mutex);
+	return !quit;
+}
 
-	TaskDef* first = list_entry(list_pop_front(head), TaskDef, list);
+static TaskRecord* _async_find_work(WorkerThread* self) {
+	TaskRecord* rec = _async_deque_pop(self->deque);
+	if(rec)
+		return rec;
 
-	// Calculate taskdef index inside taskdef pool
-	uint i = ((void*)first - taskdef_pool.data) / taskdef_pool.item_size;
-	assert(i < taskdef_pool.size);
+	rec = _async_dequeue(&tq_inject);
+	if(rec)
+		return rec;
 
-	// Mark cell as free
-	heap_push(&taskdef_pool_freecells, i, NULL);
+	// Steal, starting from the next worker so thieves spread out
+	uint i; for(i = 1; i < n_workers; ++i) {
+		rec = _async_deque_steal(&deques[(self->index + i) % n_workers]);
+		if(rec)
+			return rec;
+	}
+	return NULL;
+}
 
-	*dest = *first;
-	return true;
+static void _async_submit(TaskRecord* rec) {
+	// Workers push to their own deque, everyone else to the injection queue
+	WorkerThread* self = (WorkerThread*)pthread_getspecific(thread_worker_key);
+	if(!self || !self->deque || !_async_deque_push(self->deque, rec))
+		_async_enqueue(&tq_inject, rec);
+	_async_wake_worker();
 }
 
 // Scheduler
 
-typedef struct {
-	TaskId taskid;
-	Task task;
-	void* userdata;
-} ScheduledTaskDef;
-
-DArray async_sched_tasks;
-Heap async_sched_freecells;
-Heap async_schedule_pq;
+// Scheduled task records hang in wheel slots by their list node, so adding
+// and cancelling is O(1) and a tick only touches the tasks due in it
+static ListHead async_wheel[WHEEL_LEVELS][WHEEL_SIZE];
+// Tasks whose time has come, run one by one so any of them can cancel
+// the ones after it
+static ListHead async_due;
+static uint async_wheel_now;
+static uint async_sched_count;
+DArray async_continuations;
 
 // Current time in miliseconds
-static int _async_time(void) {
+static uint _async_time(void) {
 	return time_ms_current();
 }
 
 static void _async_init_scheduler(void) {
-	async_sched_tasks = darray_create(sizeof(ScheduledTaskDef), 0);
-	heap_init(&async_sched_freecells);
-	heap_init(&async_schedule_pq);
+	uint l; for(l = 0; l < WHEEL_LEVELS; ++l) {
+		uint i; for(i = 0; i < WHEEL_SIZE; ++i)
+			list_init(&async_wheel[l][i]);
+	}
+	list_init(&async_due);
+	async_wheel_now = _async_time() / WHEEL_TICK_MS;
+	async_sched_count = 0;
+	async_continuations = darray_create(sizeof(Continuation), 0);
 }
 
 static void _async_close_scheduler(void) {
 	async_process_schedule();
 
-	if(heap_size(&async_schedule_pq) != 0) {
+	if(async_sched_count != 0) {
 		LOG_WARNING("Closing scheduler with unfinished tasks!");
 	}
 
-	heap_free(&async_schedule_pq);
-	heap_free(&async_sched_freecells);
+	if(async_continuations.size != 0) {
+		LOG_WARNING("Closing scheduler with continuations that never ran!");
+	}
+	darray_free(&async_continuations);
+}
+
+// Puts a task into the slot of the lowest level whose turn covers it
+static void _async_wheel_insert(TaskRecord* rec) {
+	uint delta = rec->due - async_wheel_now;
+	if((int)delta <= 0) {
+		list_push_back(&async_due, &rec->list);
+		return;
+	}
+
+	uint due = rec->due;
+	if(delta >= WHEEL_SPAN) {
+		// Too far off, park it in the last level and place it again on
+		// the way down
+		delta = WHEEL_SPAN - 1;
+		due = async_wheel_now + delta;
+	}
+
+	uint level = 0;
+	while(delta >= (1U << (WHEEL_BITS * (level+1))))
+		level++;
+	uint slot = (due >> (WHEEL_BITS * level)) & (WHEEL_SIZE-1);
+	list_push_back(&async_wheel[level][slot], &rec->list);
+}
+
+// Moves everything in a slot down to where it belongs now
+static void _async_wheel_cascade(uint level, uint slot) {
+	ListHead* head = &async_wheel[level][slot];
+	while(!list_empty(head)) {
+		TaskRecord* rec = list_entry(list_pop_front(head), TaskRecord, list);
+		_async_wheel_insert(rec);
+	}
+}
+
+// Advances the wheel to now, moving the tasks due on the way to async_due
+static void _async_wheel_advance(uint now) {
+	if(async_sched_count == 0) {
+		// Nothing to pass by
+		async_wheel_now = now;
+		return;
+	}
+
+	while((int)(now - async_wheel_now) > 0) {
+		async_wheel_now++;
 
-	darray_free(&async_sched_tasks);
+		// Lower level completed a turn, bring down the next slot of the
+		// level above
+		uint l; for(l = 1; l < WHEEL_LEVELS; ++l) {
+			if(async_wheel_now & ((1U << (WHEEL_BITS * l)) - 1))
+				break;
+			_async_wheel_cascade(l, (async_wheel_now >> (WHEEL_BITS * l)) & (WHEEL_SIZE-1));
+		}
+
+		ListHead* head = &async_wheel[0][async_wheel_now & (WHEEL_SIZE-1)];
+		while(!list_empty(head))
+			list_push_back(&async_due, list_pop_front(head));
+	}
 }
 
 TaskId async_schedule(Task task, uint t, void* userdata) {
-	assert(async_sched_tasks.item_size == sizeof(ScheduledTaskDef));
+	TaskRecord* rec = _async_alloc_task(task, userdata);
+	TaskId id = rec->id;
+
+	async_enter_cs(ASYNC_SCHED_CS);
 
-	TaskId taskid = _async_new_taskid();
+	// Catch up first, slots are relative to the current tick. Round up,
+	// never run before time.
+	uint now = _async_time();
+	_async_wheel_advance(now / WHEEL_TICK_MS);
+	rec->due = (now + t + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+	rec->scheduled = true;
+	async_sched_count++;
+	_async_wheel_insert(rec);
+
+	async_leave_cs(ASYNC_SCHED_CS);
+
+	return id;
+}
+
+void async_then(TaskId id, Task task, void* userdata) {
+	Continuation cont = {id, task, userdata};
 
 	async_enter_cs(ASYNC_SCHED_CS);
+	darray_append(&async_continuations, &cont);
+	async_leave_cs(ASYNC_SCHED_CS);
+}
 
-	size_t i = ~0;
-	if(heap_size(&async_sched_freecells) > 0) {
-		// Use free cell
-		i = heap_pop(&async_sched_freecells, NULL);
-	}
-	else {
-		// Append new cell
-		i = async_sched_tasks.size;
-		ScheduledTaskDef dummy = {0, NULL, NULL};
-		darray_append(&async_sched_tasks, &dummy);
+bool async_cancel(TaskId id) {
+	uint slot = id & TASK_SLOT_MASK;
+	assert(slot / TASK_CHUNK_SIZE < taskrec_n_chunks);
+	TaskRecord* rec = &taskrec_chunks[slot / TASK_CHUNK_SIZE][slot % TASK_CHUNK_SIZE];
+
+	async_enter_cs(ASYNC_SCHED_CS);
+
+	// Only scheduled tasks which haven't started yet can be taken back
+	bool cancel = rec->scheduled && rec->id == id;
+	if(cancel) {
+		list_remove(&rec->list);
+		rec->scheduled = false;
+		async_sched_count--;
 	}
-	assert(i != ~0);
 
-	// Fill in data, push to the heap
-	ScheduledTaskDef* defs = DARRAY_DATA_PTR(async_sched_tasks, ScheduledTaskDef);
-	ScheduledTaskDef* new = &defs[i];
+	async_leave_cs(ASYNC_SCHED_CS);
 
-	new->taskid = taskid;
-	new->task = task;
-	new->userdata = userdata;
+	// Never ran, but finished as far as everyone else is concerned
+	if(cancel)
+		_async_release_task(rec);
+
+	return cancel;
+}
 
-	int schedule_t = t + _async_time();
-	heap_push(&async_schedule_pq, schedule_t, (void*)i);
+uint async_schedule_wait(void) {
+	uint wait = ~0;
+
+	async_enter_cs(ASYNC_SCHED_CS);
+
+	// Continuations wait on other threads, look again next tick
+	if(async_continuations.size)
+		wait = WHEEL_TICK_MS;
+
+	if(!list_empty(&async_due)) {
+		wait = 0;
+	}
+	else if(async_sched_count) {
+		// Within a level the first occupied slot after the current one
+		// holds the earliest tasks, the earliest overall is in one of those
+		uint now = _async_time();
+		uint l; for(l = 0; l < WHEEL_LEVELS; ++l) {
+			uint shift = WHEEL_BITS * l;
+			uint i; for(i = 1; i <= WHEEL_SIZE; ++i) {
+				ListHead* head = &async_wheel[l][((async_wheel_now >> shift) + i) & (WHEEL_SIZE-1)];
+				if(list_empty(head))
+					continue;
+				TaskRecord* rec;
+				list_for_each_entry(rec, head, list) {
+					int ms = (int)(rec->due * WHEEL_TICK_MS - now);
+					wait = MIN(wait, (uint)MAX(ms, 0));
+				}
+				break;
+			}
+		}
+	}
 
 	async_leave_cs(ASYNC_SCHED_CS);
 
-	return taskid;
+	return wait;
 }
 
 void async_process_schedule(void) {
 	async_enter_cs(ASYNC_SCHED_CS);
-	int t = _async_time();
 
-	while(  heap_size(&async_schedule_pq) &&
-			heap_peek(&async_schedule_pq, NULL) <= t) {
+	_async_wheel_advance(_async_time() / WHEEL_TICK_MS);
 
-		// Pop highest priority task
-		void* data;
-		heap_pop(&async_schedule_pq, &data);
-		size_t i = (size_t)data;
-		assert(i < async_sched_tasks.size);
-		ScheduledTaskDef* defs = DARRAY_DATA_PTR(async_sched_tasks, ScheduledTaskDef);
-		ScheduledTaskDef* def = &defs[i];
+	while(!list_empty(&async_due)) {
+		TaskRecord* rec = list_entry(list_pop_front(&async_due), TaskRecord, list);
+		rec->scheduled = false;
+		async_sched_count--;
 
-		// Do it
+		// Do it, this also marks it as finished
 		async_leave_cs(ASYNC_SCHED_CS);
-		(*def->task)(def->userdata);
+		_async_execute(rec);
 		async_enter_cs(ASYNC_SCHED_CS);
+	}
+
+	// Run continuations of finished tasks, in the order they were added
+	uint i = 0;
+	while(i < async_continuations.size) {
+		Continuation* conts = DARRAY_DATA_PTR(async_continuations, Continuation);
+		if(!async_is_finished(conts[i].after)) {
+			++i;
+			continue;
+		}
 
-		// Remove it from schedule task pool
-		heap_push(&async_sched_freecells, i, NULL);
+		// Continuation might add new ones, which reallocates the array
+		Continuation cont = conts[i];
+		darray_remove(&async_continuations, i);
 
-		// Mark taskid as finished
-		_async_finish_taskid(def->taskid);
+		async_leave_cs(ASYNC_SCHED_CS);
+		(*cont.task)(cont.userdata);
+		async_enter_cs(ASYNC_SCHED_CS);
 	}
 
 	async_leave_cs(ASYNC_SCHED_CS);
@@ -536,59 +768,83 @@ void async_process_schedule(void) {
 
 static void* _worker(void* userdata) {
 	WorkerThread* self = (WorkerThread*)userdata;
+	pthread_setspecific(thread_worker_key, self);
+
+	LOG_INFO("Thread %s starting work\n", self->name);
+	self->alive = true;
+	while(true) {
+		TaskRecord* rec = _async_find_work(self);
+		if(rec) {
+			_async_execute(rec);
+			continue;
+		}
+
+		if(!_async_sleep()) {
+			LOG_INFO("Thread %s exiting", self->name);
+			break;
+		}
+	}
+	self->alive = false;
+	return NULL;
+}
+
+static void* _io_worker(void* userdata) {
+	WorkerThread* self = (WorkerThread*)userdata;
+	pthread_setspecific(thread_worker_key, self);
 
 	LOG_INFO("Thread %s starting work\n", self->name);
 	self->alive = true;
 	while(true) {
-		TaskDef task;
-		bool have_task = false;
+		TaskRecord* rec = NULL;
 
-		pthread_mutex_lock(&self->tq->mutex);
-again:
-		if(self->tq->count == 0) {
+		pthread_mutex_lock(&tq_io.mutex);
+		while(tq_io.count == 0) {
 			// Wait till there's a task available
-			pthread_cond_wait(&self->tq->cond, &self->tq->mutex);
-			goto again;
+			pthread_cond_wait(&tq_io.cond, &tq_io.mutex);
 		}
-		if(self->tq->count > 0) {
-				// Get the task
-				have_task = _async_dequeue(&self->tq->queue, &task);
-				self->tq->count--;
+		if(tq_io.count > 0) {
+			rec = list_entry(list_pop_front(&tq_io.queue), TaskRecord, list);
+			tq_io.count--;
 		}
+		pthread_mutex_unlock(&tq_io.mutex);
 
-		pthread_mutex_unlock(&self->tq->mutex);
-
-		if(!have_task) {
+		if(!rec) {
 			// We got signal, but there's no tasks - exit
 			LOG_INFO("Thread %s exiting", self->name);
 			break;
 		}
 
-		// Do the task
-		(*task.task)(task.userdata);
-
-		// Mark finished
-		_async_finish_taskid(task.id);
+		_async_execute(rec);
 	}
 	self->alive = false;
 	return NULL;
 }
 
-static void _create_thread(const char* name, TaskQueue* queue) {
+static void _create_thread(const char* name, TaskDeque* deque, void* (*func)(void*)) {
 	assert(async_initialized);
 
 	WorkerThread* thread = &threads[n_threads];
-	n_threads++;
 	assert(n_threads < MAX_THREADS);
 
 	assert(strlen(name) < THREAD_NAME_LEN);
 	strcpy(thread->name, name);
-	thread->tq = queue;
+	thread->deque = deque;
 	thread->alive = false;
+	thread->index = deque ? n_workers : 0;
+
+	if(deque) {
+		deque->top = deque->bottom = 0;
+		n_workers++;
+	}
 
-	int ret = pthread_create(&thread->thread, NULL, _worker, (void*)thread);
-	if(ret != 0)
+	int ret = pthread_create(&thread->thread, NULL, func, (void*)thread);
+	if(ret != 0) {
 		LOG_ERROR("Unable to create worker thread");
+		if(deque)
+			n_workers--;
+		return;
+	}
+	n_threads++;
 
 	LOG_INFO("Created thread %s", name);
 }
@@ -596,20 +852,33 @@ static void _create_thread(const char* name, TaskQueue* queue) {
 static void _check_io_thread(void) {
 	async_enter_cs(ASYNC_THREAD_CS);
 	if(!io_thread_created) {
-		_create_thread("io", &tq_io);
+		_create_thread("io", NULL, _io_worker);
 		io_thread_created = true;
 	}
 	async_leave_cs(ASYNC_THREAD_CS);
 }
 
+// One worker per core, less the one the main thread keeps busy
+static uint _async_worker_count(void) {
+	long cores = 2;
+#ifdef _SC_NPROCESSORS_ONLN
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return cores - 1 < 1 ? 1 : MIN(cores - 1, MAX_WORKERS);
+}
+
 static void _check_async_threads(void) {
+	if(async_threads_created)
+		return;
 	async_enter_cs(ASYNC_THREAD_CS);
 	if(!async_threads_created) {
-		char name[8];
-		uint i; for(i = 0; i < ASYNC_THREADS; ++i) {
+		char name[THREAD_NAME_LEN];
+		uint n = _async_worker_count();
+		uint i; for(i = 0; i < n; ++i) {
 			sprintf(name, "async %d", i);
-			_create_thread(name, &tq_async);
+			_create_thread(name, &deques[n_workers], _worker);
 		}
+		__sync_synchronize();
 		async_threads_created = true;
 	}
 	async_leave_cs(ASYNC_THREAD_CS);
@@ -618,13 +887,27 @@ static void _check_async_threads(void) {
 TaskId async_run(Task task, void* userdata) {
 	_check_async_threads();
 
-	TaskId id = _async_new_taskid();
+	TaskRecord* rec = _async_alloc_task(task, userdata);
+	TaskId id = rec->id;
+	_async_submit(rec);
 
-	pthread_mutex_lock(&tq_async.mutex);
-	_async_enqueue(&tq_async.queue, task, id, userdata);
-	tq_async.count++;
-	pthread_mutex_unlock(&tq_async.mutex);
-	pthread_cond_signal(&tq_async.cond);
+	return id;
+}
+
+TaskId async_run_child(Task task, void* userdata) {
+	_check_async_threads();
+
+	TaskRecord* rec = _async_alloc_task(task, userdata);
+	TaskId id = rec->id;
+
+	// The running task stays unfinished until the child is done
+	TaskRecord* parent = (TaskRecord*)pthread_getspecific(thread_task_key);
+	if(parent) {
+		__sync_fetch_and_add(&parent->pending, 1);
+		rec->parent = parent;
+	}
+
+	_async_submit(rec);
 
 	return id;
 }
@@ -632,14 +915,11 @@ TaskId async_run(Task task, void* userdata) {
 TaskId async_run_io(Task task, void* userdata) {
 	_check_io_thread();
 
-	TaskId id = _async_new_taskid();
+	TaskRecord* rec = _async_alloc_task(task, userdata);
+	TaskId id = rec->id;
 
-	pthread_mutex_lock(&tq_io.mutex);
-	_async_enqueue(&tq_io.queue, task, id, userdata);
-	tq_io.count++;
-	pthread_mutex_unlock(&tq_io.mutex);
+	_async_enqueue(&tq_io, rec);
 	pthread_cond_signal(&tq_io.cond);
 
 	return id;
 }
-
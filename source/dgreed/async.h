@@ -23,6 +23,11 @@ void async_leave_cs(CriticalSection cs);
 // Run task asynchronously (might run on a different thread)
 TaskId async_run(Task task, void* userdata);
 
+// Run task asynchronously as a child of the task currently running on
+// this thread. The parent is not finished until all of its children are.
+// Outside of a task this is the same as async_run.
+TaskId async_run_child(Task task, void* userdata);
+
 // Run task asynchronously on a special io thread. All io tasks are
 // executed in-order.
 TaskId async_run_io(Task task, void* userdata);
@@ -31,9 +36,27 @@ TaskId async_run_io(Task task, void* userdata);
 // Timing is precise to 1/60 of a second.
 TaskId async_schedule(Task task, uint t, void* userdata);
 
-// Returns true if task is finished
+// Take back a scheduled task which hasn't run yet. It counts as finished
+// from then on. Returns false if it already ran or isn't scheduled.
+bool async_cancel(TaskId id);
+
+// Miliseconds until a scheduled task is due or continuations should be
+// checked again, ~0 if nothing is waiting. Lets the main thread sleep
+// until then.
+uint async_schedule_wait(void);
+
+// Returns true if task is finished. Never blocks, safe to poll from
+// any thread.
 bool async_is_finished(TaskId id);
 
+// Run task on the main thread, from async_process_schedule, once the
+// task with the given id is finished.
+void async_then(TaskId id, Task task, void* userdata);
+
+// Run due scheduled tasks and ready continuations. Call once per frame
+// from the main thread.
+void async_process_schedule(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -234,6 +234,12 @@ static void _aatree_delete_node(AATree* tree) {
 	AATNodeIdx idx = tree->del_idx;
 	AATNodeIdx last = tree->tree.size-1;
 
+	// Deleted node is the last one, nothing to move
+	if(idx == last) {
+		tree->tree.size--;
+		return;
+	}
+
 	// Copy last node to its place
 	nodes[idx] = nodes[last];	
 
@@ -541,8 +547,8 @@ static AATNodeIdx _aatree_remove(AATree* tree, AATNodeIdx idx, int key) {
 		_aatree_mark_delete(tree, tree->rem_last);
 		tree->did_del = true;
 	}
-	else if ((node_left && node->level-1 > node_left->level) ||
-			 (node_right && node->level-1 > node_right->level)) {
+	else if (node->level-1 > (node_left ? node_left->level : 0) ||
+			 node->level-1 > (node_right ? node_right->level : 0)) {
 
 		// Perform rebalancing choreography on the way back
 		assert(tree->did_del);
@@ -21,6 +21,7 @@
 #include "ig_distorter.h"
 #include "ig_resource_manager.h"
 #include "ig_node.h"
+#include "ig_touch_grid.h"
 #include "ig_touches.h"
 #include "ig_scene.h"
 #include "ig_director.h"
@@ -28,5 +29,7 @@
 #include "ig_button.h"
 #include "ig_animation.h"
 #include "ig_label.h"
+#include "ig_tween.h"
+#include "ig_profiler.h"
 
 #endif // IG_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "ig_animation.h"
 #include "ig_resource_manager.h"
+#include "ig_director.h"
+#include "ig_tween.h"
 
 IGAnimation::IGAnimation() {
 	image = NULL;
@@ -7,8 +9,6 @@ IGAnimation::IGAnimation() {
 	size = IGRect();
 	z = 0;
 	tag = 0;
-	delay = 0;
-	start = s3eTimerGetMs();
 	currentFrame = frames.begin();
 }
 
@@ -17,23 +17,27 @@ IGAnimation::~IGAnimation() {
 	while(i!=frames.end()) {
 		IGAnimation::Frame* frame = *i;
 		if(frame->image != NULL)
-			IGResourceManager::getInstance()->freeImage(frame->name);
+			IGResourceManager::getInstance()->freeImage(frame->id);
 		i = frames.erase(i);
 		delete frame;
 	}
 	image = NULL;
 }
 
-void IGAnimation::update() {
-	if((s3eTimerGetMs() - start) >= delay) {
-		start = s3eTimerGetMs();
-		
-		// next frame
-		currentFrame++;
-		if(currentFrame == frames.end()) {
-			currentFrame = frames.begin();
-		}
+const char* IGAnimation::className() {
+	return "IGAnimation";
+}
+
+void IGAnimation::tween(int property, float value) {
+	if(property != IGTweenFrame) {
+		IGSprite::tween(property, value);
+		return;
+	}
+	unsigned int frame = (unsigned int)value % frames.size();
+	if(currentFrame != frames.begin()+frame) {
+		currentFrame = frames.begin()+frame;
 		image = ((IGAnimation::Frame*)(*currentFrame))->image;
+		IGDirector::getInstance()->invalidate();
 	}
 }
 
@@ -42,13 +46,16 @@ void IGAnimation::firstFrame() {
 	image = ((IGAnimation::Frame*)(*currentFrame))->image;
 }
 
-void IGAnimation::addFrame(std::string name) {
+void IGAnimation::addFrame(const char* name) {
 	IGAnimation::Frame* frame = new IGAnimation::Frame;
-	frame->name = name;
-	frame->image = IGResourceManager::getInstance()->getImage(frame->name);
+	frame->id = IGResourceManager::getInstance()->getId(name);
+	frame->image = IGResourceManager::getInstance()->getImage(frame->id);
 	frames.push_back(frame);
 }
 
 void IGAnimation::setFPS(float framesPerSecond) {
-	delay = 1000 / framesPerSecond;
+	// the frame number runs through the list on a looping tween
+	if(frames.empty())
+		return;
+	IGTweens::getInstance()->add(this, IGTweenFrame, 0, (float)frames.size(), (int32)(frames.size()*1000/framesPerSecond), 0, IGEaseLinear, true);
 }
\ No newline at end of file
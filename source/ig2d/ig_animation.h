@@ -11,22 +11,20 @@ class IGAnimation: public IGSprite {
 public:
 	IGAnimation();
 	virtual ~IGAnimation();
-	void update();
+	virtual const char* className();
+	void tween(int property, float value);
 	void firstFrame();
-	void addFrame(std::string name);
+	void addFrame(const char* name);
 	void setFPS(float framesPerSecond);
 	
 protected:
 	struct Frame {
 		CIw2DImage* image;
-		std::string name;
+		IGResourceId id;
 	};
 	
 	std::vector<IGAnimation::Frame*> frames;
 	std::vector<IGAnimation::Frame*>::iterator currentFrame;
-
-	float delay;
-	int64 start;
 };
 
 #endif // IG_ANIMATION_H
\ No newline at end of file
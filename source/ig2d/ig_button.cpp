@@ -2,6 +2,7 @@
 #include "ig_resource_manager.h"
 
 IGButton::IGButton() {
+	imageNormalId = imageSelectedId = IGResourceNone;
 	imageNormal = NULL;
 	imageSelected = NULL;
 	image = NULL;
@@ -12,20 +13,22 @@ IGButton::IGButton() {
 }
 
 IGButton::IGButton(const IGButton& b) {
+	imageNormalId = b.imageNormalId;
+	imageSelectedId = b.imageSelectedId;
 	imageNormal = b.imageNormal;
 	imageSelected = b.imageSelected;
 	image = imageNormal;
-	position = IGPoint(b.position);
+	position = previousPosition = IGPoint(b.position);
 	size = IGRect(b.size);
 	z = b.z;
 	tag = b.tag;
 }
 
 IGButton::IGButton(const char *resource, const char *selectedResource, IGPoint _position, IGRect _size, IGRect _touchSize, int _z, int _tag) {
-	imageNormalName = std::string(resource);
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string(selectedResource);
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId(resource);
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId(selectedResource);
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(_position, _size);
 	touchSize = _touchSize;
@@ -35,8 +38,12 @@ IGButton::IGButton(const char *resource, const char *selectedResource, IGPoint _
 
 IGButton::~IGButton() {
 	image = NULL;
-	IGResourceManager::getInstance()->freeImage(imageNormalName);
-	IGResourceManager::getInstance()->freeImage(imageSelectedName);
+	IGResourceManager::getInstance()->freeImage(imageNormalId);
+	IGResourceManager::getInstance()->freeImage(imageSelectedId);
+}
+
+const char* IGButton::className() {
+	return "IGButton";
 }
 
 bool IGButton::touch(s3ePointerTouchEvent* event) {
@@ -65,6 +72,12 @@ bool IGButton::touch(s3ePointerTouchEvent* event) {
 	return false;
 }
 
+bool IGButton::touchArea(IGPoint& center, IGRect& area) {
+	center = position;
+	area = touchSize;
+	return true;
+}
+
 void IGButton::buttonPressed() {
 	// for overriding
 }
@@ -11,8 +11,8 @@ class IGButton: public IGSprite {
 public:
 	CIw2DImage* imageNormal; // normal image
 	CIw2DImage* imageSelected; // selected image
-	std::string imageNormalName;
-	std::string imageSelectedName;
+	IGResourceId imageNormalId;
+	IGResourceId imageSelectedId;
 	IGRect touchSize;
 
 	// constructors and destructors
@@ -20,9 +20,11 @@ public:
 	IGButton(const IGButton& b);
 	IGButton(const char *resource, const char *selectedResource, IGPoint _position, IGRect _size, IGRect _touchSize, int _z=0, int _tag=0);
 	virtual ~IGButton();
+	virtual const char* className();
 	
 	// pass a touch to the sprite, return true if handled
 	bool touch(s3ePointerTouchEvent* event);
+	bool touchArea(IGPoint& center, IGRect& area);
 	virtual void buttonReleased();
 	virtual void buttonPressed();
 };
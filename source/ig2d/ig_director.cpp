@@ -1,5 +1,8 @@
 #include "ig_director.h"
 #include "ig_global.h"
+#include "ig_resource_manager.h"
+#include "ig_profiler.h"
+#include "ig_tween.h"
 #include "Iw2D.h"
 
 IGDirector* IGDirector::instance = NULL;
@@ -13,6 +16,11 @@ IGDirector* IGDirector::getInstance() {
 IGDirector::IGDirector() {
 	IGLog("Director init");
 	scene = NULL;
+	time = 0;
+	interpolation = 1.0f;
+	lastInput = s3eTimerGetMs();
+	dirty = true;
+	awake = false;
 }
 
 IGDirector::~IGDirector() {
@@ -30,20 +38,73 @@ void IGDirector::switchScene(IGScene* _scene) {
 	scene = _scene;
 	if(sceneToDelete != NULL)
 		delete sceneToDelete;
+	invalidate();
+	// groups only the old scene used go, and with them the unused images
+	// made from them; nothing on screen, nothing worth keeping
+	if(IGScene::unloadGroups(scene) || scene == NULL)
+		IGResourceManager::getInstance()->purgeUnused();
 }
 
-void IGDirector::display() {
-	if(scene != NULL)
-		scene->display();
-	Iw2DFinishDrawing();
+void IGDirector::display(float _interpolation) {
+	interpolation = _interpolation;
+	// a frame between two ticks is not final
+	dirty = (interpolation < 1.0f && awake);
+	{
+		IG_PROFILE("IGDirector::display");
+		if(scene != NULL) {
+			IG_PROFILE(scene->className());
+			scene->display();
+		}
+#ifdef IG_PROFILER
+		IGProfiler::getInstance()->display();
+#endif
+		Iw2DFinishDrawing();
+	}
+#ifdef IG_PROFILER
+	IGProfiler::getInstance()->frame();
+#endif
 }
 
-void IGDirector::update() {
-	if(scene != NULL)
+void IGDirector::update(int32 ms) {
+	IG_PROFILE("IGDirector::update");
+	time += ms;
+	awake = false;
+	if(scene != NULL) {
+		// remember where things were, to interpolate up to where they go
+		scene->snapshot();
+		IGTweens::getInstance()->update(ms);
+		IG_PROFILE(scene->className());
 		scene->update();
+	}
 }
 
 void IGDirector::touch(s3ePointerTouchEvent* event) {
+	input();
+	invalidate();
 	if(scene != NULL)
 		scene->touch(event);
 }
+
+int64 IGDirector::getTime() {
+	return time;
+}
+
+void IGDirector::input() {
+	lastInput = s3eTimerGetMs();
+}
+
+void IGDirector::invalidate() {
+	dirty = true;
+}
+
+void IGDirector::keepAwake() {
+	awake = true;
+}
+
+bool IGDirector::needsRedraw() {
+	return dirty;
+}
+
+bool IGDirector::isIdle() {
+	return !dirty && !awake;
+}
@@ -22,13 +22,31 @@ public:
 	void switchScene(IGScene* _scene);
 
 	// display and update
-	void display();
-	void update();
+	void display(float _interpolation = 1.0f);
+	void update(int32 ms);
 
 	// hand touches for the current scene
 	void touch(s3ePointerTouchEvent* event);
 
+	// simulation time, advanced by update()
+	int64 getTime();
+	// how far display() is between the last two updates (0..1)
+	float interpolation;
+	// when the player last touched the screen or a key
+	int64 lastInput;
+	void input();
+
+	// redraw protocol: changes mark the frame dirty, nodes waiting on
+	// time keep the loop ticking, otherwise the loop may sleep
+	void invalidate();
+	void keepAwake();
+	bool needsRedraw();
+	bool isIdle();
+
 private:
+	int64 time;
+	bool dirty;
+	bool awake;
 	static IGDirector* instance;
 };
 
@@ -7,6 +7,16 @@ void IGLog(const char* str) {
 	s3eDebugOutputString(newStr);
 }
 
+// hash of a resource name (FNV-1a)
+unsigned int IGHashString(const char* str) {
+	unsigned int hash = 2166136261u;
+	while(*str) {
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
 // IGPoint methods
 IGPoint::IGPoint() {
 	x = 0;
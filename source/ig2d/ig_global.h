@@ -7,6 +7,9 @@
 // debug to the console
 void IGLog(const char* str);
 
+// hash of a resource name (FNV-1a)
+unsigned int IGHashString(const char* str);
+
 // points and rects
 class IGPoint {
 public:
@@ -1,5 +1,7 @@
 #include "ig_label.h"
 #include "ig_resource_manager.h"
+#include "ig_director.h"
+#include "ig_profiler.h"
 
 IGLabel::IGLabel() {
 	image = NULL;
@@ -9,6 +11,7 @@ IGLabel::IGLabel() {
 	tag = 0;
 	this->setOpacity(255);
 	str = std::string("");
+	fontId = IGResourceNone;
 	font = NULL;
 	alignHorizontal = IW_2D_FONT_ALIGN_CENTRE;
 	alignVertical = IW_2D_FONT_ALIGN_CENTRE;
@@ -16,11 +19,11 @@ IGLabel::IGLabel() {
 
 IGLabel::IGLabel(const IGLabel& s) {
 	image = NULL;
-	position = IGPoint(s.position);
+	position = previousPosition = IGPoint(s.position);
 	size = IGRect(s.size);
 	z = s.z;
 	tag = s.tag;
-	fontName = s.fontName;
+	fontId = s.fontId;
 	font = s.font;
 	alignHorizontal = s.alignHorizontal;
 	alignVertical = s.alignVertical;
@@ -33,8 +36,8 @@ IGLabel::IGLabel(const char *resource, std::string _str, IGPoint _position, IGRe
 	set(_position, _size);
 	z = _z;
 	tag = _tag;
-	fontName = std::string(resource);
-	font = IGResourceManager::getInstance()->getFont(fontName);
+	fontId = IGResourceManager::getInstance()->getId(resource);
+	font = IGResourceManager::getInstance()->getFont(fontId);
 	alignHorizontal = IW_2D_FONT_ALIGN_CENTRE;
 	alignVertical = IW_2D_FONT_ALIGN_CENTRE;
 	setOpacity(255);
@@ -43,7 +46,11 @@ IGLabel::IGLabel(const char *resource, std::string _str, IGPoint _position, IGRe
 
 IGLabel::~IGLabel() {
 	if(font != NULL)
-		IGResourceManager::getInstance()->freeFont(fontName);
+		IGResourceManager::getInstance()->freeFont(fontId);
+}
+
+const char* IGLabel::className() {
+	return "IGLabel";
 }
 
 void IGLabel::display() {
@@ -52,13 +59,23 @@ void IGLabel::display() {
 		Iw2DSetColour(color);	// set the color
 		
 		// draw the string
+		IGPoint p = displayPosition();
+		IG_PROFILE("Iw2DDrawString");
 		Iw2DDrawString(str.c_str(),
-			CIwSVec2((int)((position.x-size.width/2)+IGDistorter::getInstance()->offsetX), (int)((position.y-size.height/2)+IGDistorter::getInstance()->offsetY)),
+			CIwSVec2((int)((p.x-size.width/2)+IGDistorter::getInstance()->offsetX), (int)((p.y-size.height/2)+IGDistorter::getInstance()->offsetY)),
 			CIwSVec2((int)size.width, (int)size.height),
 			alignHorizontal, alignVertical);
 	}
 }
 
 void IGLabel::setString(std::string _str) {
+	if(_str == str)
+		return;
+#ifndef __S3E__
+	// the old text will not be drawn again by this label
+	if(font != NULL && !str.empty())
+		Iw2DReleaseString(font, str.c_str());
+#endif
 	str = _str;
+	IGDirector::getInstance()->invalidate();
 }
@@ -7,7 +7,7 @@
 
 class IGLabel: public IGSprite {
 public:
-	std::string fontName;
+	IGResourceId fontId;
 	CIw2DFont* font;
 
 	// constructor and destructor
@@ -18,6 +18,7 @@ public:
 
 	// display
 	virtual void display();
+	virtual const char* className();
 
 	// set the string
 	void setString(std::string _str);
@@ -1,15 +1,27 @@
 #include "ig_node.h"
 #include "ig_distorter.h"
+#include "ig_touch_grid.h"
+#include "ig_director.h"
+#include "ig_profiler.h"
+#include "ig_tween.h"
 #include "Iw2D.h"
 
 IGNode::IGNode() {
 	sorted = false;
 	numChildren = 0;
 	parent = NULL;
+	touchGrid = NULL;
 }
 
 IGNode::~IGNode() {
 	removeAllChildren();
+	if(touchGrid != NULL)
+		delete touchGrid;
+	IGTweens::forget(this);
+}
+
+const char* IGNode::className() {
+	return "IGNode";
 }
 
 void IGNode::addChild(IGNode* node) {
@@ -17,6 +29,9 @@ void IGNode::addChild(IGNode* node) {
 	children.push_back(node);
 	sorted = false;
 	numChildren++;
+	if(touchGrid != NULL)
+		touchGrid->invalidate();
+	IGDirector::getInstance()->invalidate();
 }
 
 IGNode* IGNode::getChildByTag(int tag) {
@@ -36,7 +51,10 @@ void IGNode::removeChildByTag(int tag) {
 		IGNode* node = *i;
 		if(node->tag == tag) {
 			i = children.erase(i);
+			if(touchGrid != NULL)
+				touchGrid->forget(node);
 			delete node;
+			IGDirector::getInstance()->invalidate();
 		} else {
 			++i;
 		}
@@ -48,25 +66,39 @@ void IGNode::removeAllChildren() {
 	while(i!=children.end()) {
 		IGNode* node = *i;
 		i = children.erase(i);
+		if(touchGrid != NULL)
+			touchGrid->forget(node);
 		delete node;
+		IGDirector::getInstance()->invalidate();
 	}
 }
 
 void IGNode::setZ(int _z) {
 	z = _z;
 	sorted = false;
+	if(parent != NULL)
+		parent->sorted = false;
+	invalidateTouch();
+	IGDirector::getInstance()->invalidate();
 }
 
-void IGNode::display() {
-	// make sure it's sorted first
+void IGNode::sortChildren() {
 	if(sorted == false) {
 		std::sort(children.begin(), children.end(), IGNode::compareNodePredicate);
 		sorted = true;
+		if(touchGrid != NULL)
+			touchGrid->invalidate();
 	}
+}
+
+void IGNode::display() {
+	// make sure it's sorted first
+	sortChildren();
 
 	std::vector<IGNode*>::iterator i;
 	for(i=children.begin(); i!=children.end(); ++i) {
 		IGNode* node = *i;
+		IG_PROFILE(node->className());
 		node->display();
 		Iw2DSetColour(IGDistorter::getInstance()->colorWhiteInt);
 	}
@@ -80,7 +112,21 @@ void IGNode::update() {
 	}
 }
 
+void IGNode::tween(int property, float value) {
+}
+
+void IGNode::snapshot() {
+	std::vector<IGNode*>::iterator i;
+	for(i=children.begin(); i!=children.end(); ++i) {
+		IGNode* node = *i;
+		node->snapshot();
+	}
+}
+
 bool IGNode::touch(s3ePointerTouchEvent* event) {
+	if(touchGrid != NULL)
+		return touchGrid->touch(event);
+
 	std::vector<IGNode*>::iterator i;
 	for(i=children.begin(); i!=children.end(); ++i) {
 		IGNode* node = *i;
@@ -91,6 +137,27 @@ bool IGNode::touch(s3ePointerTouchEvent* event) {
 	return false;
 }
 
+bool IGNode::touchArea(IGPoint& center, IGRect& area) {
+	return false;
+}
+
+bool IGNode::isTouchable() {
+	// plain nodes only pass touches on to their children
+	return !children.empty();
+}
+
+void IGNode::useTouchGrid() {
+	if(touchGrid == NULL)
+		touchGrid = new IGTouchGrid(this);
+}
+
+void IGNode::invalidateTouch() {
+	IGPoint center;
+	IGRect area;
+	if(parent != NULL && parent->touchGrid != NULL && (touchArea(center, area) || isTouchable()))
+		parent->touchGrid->invalidate();
+}
+
 bool IGNode::compareNodePredicate(IGNode* node1, IGNode* node2) {
 	return (node1->z < node2->z);
 }
@@ -5,6 +5,9 @@
 #include <vector>
 #include <algorithm>
 #include "s3e.h"
+#include "ig_global.h"
+
+class IGTouchGrid;
 
 class IGNode {
 public:
@@ -23,21 +26,35 @@ public:
 	void removeChildByTag(int tag);
 	void removeAllChildren();
 	void setZ(int _z);
+	void sortChildren();
 	IGNode* parent;
 
 	// display and update stuff
 	virtual void display();
+	virtual const char* className();
 	virtual void update();
+	virtual void snapshot();
+
+	// set a property driven by IGTweens, see IGTweenProperty
+	virtual void tween(int property, float value);
 	
 	// pass a touch to the scene, return true if handled
 	virtual bool touch(s3ePointerTouchEvent* event);
 
+	// touch dispatch: nodes with an area only get touches inside it,
+	// nodes overriding touch without an area must say they are touchable
+	virtual bool touchArea(IGPoint& center, IGRect& area);
+	virtual bool isTouchable();
+	void useTouchGrid();
+	void invalidateTouch();
+
 	// operator overloaders (compares z)
 	static bool compareNodePredicate(IGNode* node1, IGNode* node2);
 	bool operator < (IGNode node);
 
 private:
 	bool sorted;
+	IGTouchGrid* touchGrid;
 };
 
 #endif // IG_NODE_H
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "ig_profiler.h"
+#include "ig_distorter.h"
+#include "Iw2D.h"
+#include "s3eAudio.h"
+#include <stdio.h>
+#include <string.h>
+#include <map>
+
+#define IG_PROFILER_SUMMARY_FRAMES 30
+#define IG_PROFILER_GRAPH_HEIGHT 66 // px, 2 per ms
+#define IG_PROFILER_LINE_HEIGHT 16
+
+IGProfiler* IGProfiler::instance = NULL;
+
+IGProfiler* IGProfiler::getInstance() {
+	if(instance == NULL)
+		instance = new IGProfiler();
+	return instance;
+}
+
+IGProfiler::IGProfiler() {
+	origin = s3eTimerGetUSTNanoseconds();
+	samples = new Sample[IG_PROFILER_SAMPLES];
+	numSamples = 0;
+	numFrames = 0;
+	depth = 0;
+	memset(frames, 0, sizeof(frames));
+	overlay = true;
+	fontId = IGResourceNone;
+	font = NULL;
+}
+
+IGProfiler::~IGProfiler() {
+	if(fontId != IGResourceNone)
+		IGResourceManager::getInstance()->freeFont(fontId);
+	delete[] samples;
+}
+
+void IGProfiler::shutdown() {
+	if(instance != NULL)
+		delete instance;
+	instance = NULL;
+}
+
+uint32 IGProfiler::now() {
+	return (uint32)((s3eTimerGetUSTNanoseconds() - origin) / 1000);
+}
+
+void IGProfiler::begin(const char* name) {
+	if(depth < IG_PROFILER_DEPTH) {
+		uint32 index = numSamples++;
+		Sample& s = samples[index % IG_PROFILER_SAMPLES];
+		s.name = name;
+		s.depth = depth;
+		s.total = s.self = 0;
+		stack[depth] = index;
+		childTime[depth] = 0;
+		s.start = now();
+	}
+	depth++;
+}
+
+void IGProfiler::end() {
+	if(depth == 0)
+		return;
+	depth--;
+	if(depth >= IG_PROFILER_DEPTH)
+		return;
+	Sample& s = samples[stack[depth] % IG_PROFILER_SAMPLES];
+	s.total = now() - s.start;
+	s.self = s.total - childTime[depth];
+	if(depth > 0)
+		childTime[depth-1] += s.total;
+	else
+		frames[numFrames % IG_PROFILER_FRAMES].busy += s.total;
+}
+
+void IGProfiler::frame() {
+	uint32 t = now();
+	Frame& f = frames[numFrames % IG_PROFILER_FRAMES];
+	f.duration = t - f.start;
+	f.numSamples = numSamples - f.firstSample;
+	numFrames++;
+
+	Frame& next = frames[numFrames % IG_PROFILER_FRAMES];
+	next.start = t;
+	next.duration = next.busy = 0;
+	next.firstSample = numSamples;
+	next.numSamples = 0;
+
+	if(overlay && numFrames % IG_PROFILER_SUMMARY_FRAMES == 0)
+		summarize();
+}
+
+// finished, still in the ring and none of its samples overwritten
+bool IGProfiler::isKept(uint32 f) {
+	if(f >= numFrames || numFrames - f >= IG_PROFILER_FRAMES)
+		return false;
+	return numSamples - frames[f % IG_PROFILER_FRAMES].firstSample <= IG_PROFILER_SAMPLES;
+}
+
+struct IGProfilerNameLess {
+	bool operator()(const char* a, const char* b) const { return strcmp(a, b) < 0; }
+};
+
+void IGProfiler::summarize() {
+	uint64 duration = 0, busy = 0;
+	uint32 count = 0;
+	std::map<const char*, uint64, IGProfilerNameLess> self;
+	for(uint32 f=numFrames-IG_PROFILER_SUMMARY_FRAMES; f<numFrames; f++) {
+		if(!isKept(f))
+			continue;
+		Frame& frame = frames[f % IG_PROFILER_FRAMES];
+		duration += frame.duration;
+		busy += frame.busy;
+		count++;
+		for(uint32 i=0; i<frame.numSamples; i++) {
+			Sample& s = samples[(frame.firstSample + i) % IG_PROFILER_SAMPLES];
+			self[s.name] += s.self;
+		}
+	}
+	if(count == 0)
+		return;
+
+#ifndef __S3E__
+	// the overlay text is about to change, drop the old layouts
+	if(font != NULL)
+		for(int i=0; i<=IG_PROFILER_TOP; i++)
+			Iw2DReleaseString(font, lines[i].c_str());
+#endif
+
+	char buffer[100];
+	snprintf(buffer, sizeof(buffer), "frame %.1f ms, busy %.1f ms", duration/1000.0/count, busy/1000.0/count);
+	lines[0] = buffer;
+#ifndef __S3E__
+	// the music streams on its own thread, a starved queue shows up here
+	int32 underruns = s3eAudioGetInt(S3E_AUDIO_UNDERRUNS);
+	if(underruns > 0) {
+		snprintf(buffer, sizeof(buffer), ", %d music underruns", (int)underruns);
+		lines[0] += buffer;
+	}
+#endif
+
+	// most self time first
+	for(int i=1; i<=IG_PROFILER_TOP; i++) {
+		std::map<const char*, uint64, IGProfilerNameLess>::iterator top = self.end(), j;
+		for(j=self.begin(); j!=self.end(); ++j)
+			if(top == self.end() || j->second > top->second)
+				top = j;
+		if(top == self.end()) {
+			lines[i].clear();
+			continue;
+		}
+		snprintf(buffer, sizeof(buffer), "%s %.2f ms", top->first, top->second/1000.0/count);
+		lines[i] = buffer;
+		self.erase(top);
+	}
+}
+
+void IGProfiler::display() {
+	if(!overlay)
+		return;
+	int width = (int)Iw2DGetSurfaceWidth();
+	int height = (int)Iw2DGetSurfaceHeight();
+
+	// frame times along the bottom, the busy part on top of each bar
+	int bar = width / IG_PROFILER_FRAMES;
+	if(bar < 1)
+		bar = 1;
+	Iw2DSetColour(0x80000000);
+	Iw2DFillRect(CIwSVec2(0, height-IG_PROFILER_GRAPH_HEIGHT), CIwSVec2(width, IG_PROFILER_GRAPH_HEIGHT));
+	int x = width - bar;
+	for(uint32 f=numFrames-1; isKept(f) && x >= 0; f--, x -= bar) {
+		Frame& frame = frames[f % IG_PROFILER_FRAMES];
+		int h = frame.duration / 500;
+		if(h > IG_PROFILER_GRAPH_HEIGHT)
+			h = IG_PROFILER_GRAPH_HEIGHT;
+		if(frame.duration <= 16667)
+			Iw2DSetColour(0xff00ff00);
+		else if(frame.duration <= 33333)
+			Iw2DSetColour(0xff00ffff);
+		else
+			Iw2DSetColour(0xff0000ff);
+		Iw2DFillRect(CIwSVec2(x, height-h), CIwSVec2(bar, h));
+		int b = frame.busy / 500;
+		if(b > h)
+			b = h;
+		Iw2DSetColour(0xc0c0c0c0); // premultiplied
+		Iw2DFillRect(CIwSVec2(x, height-b), CIwSVec2(bar, b));
+	}
+
+	// 60 fps mark
+	Iw2DSetColour(0xffffffff);
+	Iw2DFillRect(CIwSVec2(0, height-16667/500), CIwSVec2(width, 1));
+
+	// summary
+	if(fontId == IGResourceNone) {
+		fontId = IGResourceManager::getInstance()->getId("font_gabriola_14");
+		font = IGResourceManager::getInstance()->getFont(fontId);
+	}
+	if(font != NULL) {
+		Iw2DSetFont(font);
+		for(int i=0; i<=IG_PROFILER_TOP; i++)
+			if(!lines[i].empty())
+				Iw2DDrawString(lines[i].c_str(), CIwSVec2(4, 4+i*IG_PROFILER_LINE_HEIGHT), CIwSVec2(width-8, IG_PROFILER_LINE_HEIGHT),
+					IW_2D_FONT_ALIGN_LEFT, IW_2D_FONT_ALIGN_TOP);
+	}
+	Iw2DSetColour(IGDistorter::getInstance()->colorWhiteInt);
+}
+
+bool IGProfiler::dumpCSV(const char* path) {
+	FILE* file = fopen(path, "w");
+	if(file == NULL)
+		return false;
+	fprintf(file, "frame,name,depth,start_us,total_us,self_us\n");
+	for(uint32 f=0; f<numFrames; f++) {
+		if(!isKept(f))
+			continue;
+		Frame& frame = frames[f % IG_PROFILER_FRAMES];
+		fprintf(file, "%u,frame,-1,%u,%u,%u\n", f, frame.start, frame.duration, frame.duration-frame.busy);
+		for(uint32 i=0; i<frame.numSamples; i++) {
+			Sample& s = samples[(frame.firstSample + i) % IG_PROFILER_SAMPLES];
+			fprintf(file, "%u,%s,%d,%u,%u,%u\n", f, s.name, s.depth, s.start, s.total, s.self);
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+// chrome://tracing json
+bool IGProfiler::dumpTrace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if(file == NULL)
+		return false;
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for(uint32 f=0; f<numFrames; f++) {
+		if(!isKept(f))
+			continue;
+		Frame& frame = frames[f % IG_PROFILER_FRAMES];
+		fprintf(file, "%s{\"name\":\"frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%u,\"dur\":%u}",
+			first ? "" : ",\n", f, frame.start, frame.duration);
+		first = false;
+		for(uint32 i=0; i<frame.numSamples; i++) {
+			Sample& s = samples[(frame.firstSample + i) % IG_PROFILER_SAMPLES];
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%u,\"dur\":%u}", s.name, s.start, s.total);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
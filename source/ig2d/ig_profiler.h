@@ -0,0 +1,90 @@
+#pragma once
+#ifndef IG_PROFILER_H
+#define IG_PROFILER_H
+
+#include "s3e.h"
+#include "ig_resource_manager.h"
+
+// frames kept for the overlay and the dumps
+#define IG_PROFILER_FRAMES 128
+// timed scopes kept, shared by those frames
+#define IG_PROFILER_SAMPLES 32768
+// deepest nesting that is recorded
+#define IG_PROFILER_DEPTH 32
+// names listed in the overlay
+#define IG_PROFILER_TOP 5
+
+class IGProfiler {
+public:
+	struct Sample {
+		const char* name;
+		uint32 start; // us since the profiler started
+		uint32 total; // us, nested scopes included
+		uint32 self; // us, nested scopes excluded
+		int depth;
+	};
+	struct Frame {
+		uint32 start; // us since the profiler started
+		uint32 duration; // us until the next frame started
+		uint32 busy; // us spent in top level scopes
+		uint32 firstSample; // position in the running sample count
+		uint32 numSamples;
+	};
+
+	IGProfiler();
+	~IGProfiler();
+	static IGProfiler* getInstance();
+	static void shutdown();
+
+	// nested timed scopes, use IG_PROFILE instead of calling these
+	void begin(const char* name);
+	void end();
+
+	// close the current frame and start the next one
+	void frame();
+
+	// frame time graph and the names taking the most time
+	bool overlay;
+	void display();
+
+	// write out the frames still kept
+	bool dumpCSV(const char* path);
+	bool dumpTrace(const char* path);
+
+private:
+	uint64 origin;
+	Sample* samples;
+	uint32 numSamples; // running count, wraps around samples
+	Frame frames[IG_PROFILER_FRAMES];
+	uint32 numFrames; // running count, the current frame is not finished
+	uint32 stack[IG_PROFILER_DEPTH];
+	uint32 childTime[IG_PROFILER_DEPTH];
+	int depth;
+
+	// overlay text, refreshed every few frames
+	IGResourceId fontId;
+	CIw2DFont* font;
+	std::string lines[IG_PROFILER_TOP+1];
+	void summarize();
+
+	uint32 now();
+	bool isKept(uint32 f);
+	static IGProfiler* instance;
+};
+
+// times the enclosing block
+class IGProfileScope {
+public:
+	IGProfileScope(const char* name) { IGProfiler::getInstance()->begin(name); }
+	~IGProfileScope() { IGProfiler::getInstance()->end(); }
+};
+
+#ifdef IG_PROFILER
+#define IG_PROFILE_JOIN2(a, b) a##b
+#define IG_PROFILE_JOIN(a, b) IG_PROFILE_JOIN2(a, b)
+#define IG_PROFILE(name) IGProfileScope IG_PROFILE_JOIN(profileScope, __LINE__)(name)
+#else
+#define IG_PROFILE(name)
+#endif
+
+#endif // IG_PROFILER_H
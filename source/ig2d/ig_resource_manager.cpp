@@ -1,4 +1,8 @@
 #include "ig_resource_manager.h"
+#include "IwResManager.h"
+#include "ig_profiler.h"
+
+#define IG_RESOURCE_DEFAULT_BUDGET (16*1024*1024)
 
 IGResourceManager* IGResourceManager::instance = NULL;
 
@@ -10,6 +14,9 @@ IGResourceManager* IGResourceManager::getInstance() {
 
 IGResourceManager::IGResourceManager() {
 	IGLog("ResourceManager init");
+	lruHead = lruTail = -1;
+	unusedBytes = 0;
+	memoryBudget = IG_RESOURCE_DEFAULT_BUDGET;
 }
 
 IGResourceManager::~IGResourceManager() {
@@ -21,96 +28,233 @@ void IGResourceManager::shutdown() {
 		delete instance;
 }
 
-CIw2DImage* IGResourceManager::getImage(std::string name) {
-	// see if the resource has been loaded already
-	CIw2DImage* ret = (CIw2DImage*)this->getResource(name);
-	if(ret != NULL)
-		return (CIw2DImage*)ret;
-	
-	// resource doesn't exist, so load it
-	IGResourceManager::Resource* r = new IGResourceManager::Resource;
-	r->name = name;
-	r->data = (void*)Iw2DCreateImageResource(name.c_str());
-	r->count = 1;
-	r->type = IGResourceManagerTypeImage;
-	resources.push_back(r);
-	return (CIw2DImage*)r->data;
-}
-
-CIw2DFont* IGResourceManager::getFont(std::string name) {
-	// see if the resource has been loaded already
-	CIw2DFont* ret = (CIw2DFont*)this->getResource(name);
-	if(ret != NULL)
-		return (CIw2DFont*)ret;
-	
-	// resource doesn't exist, so load it
-	IGResourceManager::Resource* r = new IGResourceManager::Resource;
-	r->name = name;
-	r->data = (void*)Iw2DCreateFontResource(name.c_str());
-	r->count = 1;
-	r->type = IGResourceManagerTypeFont;
-	resources.push_back(r);
-	return (CIw2DFont*)r->data;
+const char* IGResourceManager::getName(IGResourceId id) {
+	if(id >= resources.size())
+		return NULL;
+	return resources[id].name.c_str();
+}
+
+CIw2DImage* IGResourceManager::getImage(IGResourceId id) {
+	return (CIw2DImage*)getResource(id, IGResourceManagerTypeImage);
+}
+
+CIw2DFont* IGResourceManager::getFont(IGResourceId id) {
+	return (CIw2DFont*)getResource(id, IGResourceManagerTypeFont);
 }
 
-void IGResourceManager::freeImage(std::string name) {
-	CIw2DImage* image = (CIw2DImage*)free(name);
-	if(image != NULL)
-		delete image;
+void IGResourceManager::freeImage(IGResourceId id) {
+	free(id);
 }
 
-void IGResourceManager::freeFont(std::string name) {
-	CIw2DFont* font = (CIw2DFont*)free(name);
-	if(font != NULL)
-		delete font;
+void IGResourceManager::freeFont(IGResourceId id) {
+	free(id);
 }
 
 void IGResourceManager::freeAllResources() {
-	std::vector<IGResourceManager::Resource*>::iterator i = resources.begin();
+	// names stay interned, so ids held elsewhere remain valid
+	std::vector<IGResourceManager::Resource>::iterator i = resources.begin();
 	while(i!=resources.end()) {
-		IGResourceManager::Resource* r = *i;
-		if(r->data != NULL) {
-			if(r->type == IGResourceManagerTypeImage)
-				delete (CIw2DImage*)r->data;
-			else if(r->type == IGResourceManagerTypeFont)
-				delete (CIw2DFont*)r->data;
-		}
-		i = resources.erase(i);
-		delete r;
+		unload(*i);
+		i->count = 0;
+		i->lruPrev = i->lruNext = -1;
+		i++;
 	}
+	lruHead = lruTail = -1;
+	unusedBytes = 0;
 }
 
-void* IGResourceManager::getResource(std::string name) {
-	// see if the resource has been loaded already
-	std::vector<IGResourceManager::Resource*>::iterator i = resources.begin();
-	while(i!=resources.end()) {
-		IGResourceManager::Resource* r = *i;
-		if(r->name == name) {
-			// found the resource
-			r->count++;
-			return r->data;
+void IGResourceManager::setMemoryBudget(unsigned int bytes) {
+	memoryBudget = bytes;
+	trim(memoryBudget);
+}
+
+void IGResourceManager::purgeUnused() {
+	trim(0);
+}
+
+void IGResourceManager::preloadGroup(const char* group) {
+#ifndef __S3E__
+	IwGetResManager()->PreloadGroup(group);
+#endif
+}
+
+float IGResourceManager::getGroupProgress(const char* group) {
+#ifdef __S3E__
+	// groups load synchronously on marmalade
+	return 1.0f;
+#else
+	return IwGetResManager()->GetGroupProgress(group);
+#endif
+}
+
+void* IGResourceManager::getResource(IGResourceId id, short int type) {
+	if(id >= resources.size())
+		return NULL;
+	int index = id;
+	IGResourceManager::Resource& r = resources[index];
+	if(r.count == 0 && r.data != NULL) {
+		// back from the unused list
+		lruRemove(index);
+		unusedBytes -= r.bytes;
+	}
+	r.count++;
+	r.type = type;
+	if(r.data == NULL)
+		return load(r);
+	return r.data;
+}
+
+void IGResourceManager::free(IGResourceId id) {
+	if(id >= resources.size() || resources[id].count == 0)
+		return;
+	int index = id;
+	IGResourceManager::Resource& r = resources[index];
+	r.count--;
+	if(r.count == 0 && r.data != NULL) {
+		// keep it around until memory is needed
+		lruPush(index);
+		unusedBytes += r.bytes;
+		trim(memoryBudget);
+	}
+}
+
+#ifdef __S3E__
+static unsigned int potSize(unsigned int v) {
+	unsigned int p = 1;
+	while(p < v)
+		p <<= 1;
+	return p;
+}
+#endif
+
+void* IGResourceManager::load(IGResourceManager::Resource& r) {
+	IG_PROFILE("IGResourceManager::load");
+	if(r.type == IGResourceManagerTypeImage) {
+		CIw2DImage* image = Iw2DCreateImageResource(r.name.c_str());
+		r.data = (void*)image;
+#ifdef __S3E__
+		// textures are padded to a power of two, at 32 bits a texel at most
+		r.bytes = image ? potSize((unsigned int)image->GetWidth()) * potSize((unsigned int)image->GetHeight()) * 4 : 0;
+#else
+		// what the texture was allocated at, trimmed, padded or compressed
+		r.bytes = Iw2DGetImageMemSize(image);
+#endif
+	}
+	else if(r.type == IGResourceManagerTypeFont) {
+		CIw2DFont* font = Iw2DCreateFontResource(r.name.c_str());
+		r.data = (void*)font;
+#ifdef __S3E__
+		// the font's texture belongs to its resource group
+		r.bytes = 0;
+#else
+		// fonts can share a texture, which only takes memory once
+		uint32 texture = Iw2DGetFontTexture(font);
+		r.bytes = texture != 0 && fontTextureUsers[texture]++ == 0 ? Iw2DGetFontMemSize(font) : 0;
+#endif
+	}
+	return r.data;
+}
+
+void IGResourceManager::unload(IGResourceManager::Resource& r) {
+	if(r.data != NULL) {
+		if(r.type == IGResourceManagerTypeImage)
+			delete (CIw2DImage*)r.data;
+		else if(r.type == IGResourceManagerTypeFont) {
+#ifndef __S3E__
+			uint32 texture = Iw2DGetFontTexture((CIw2DFont*)r.data);
+			if(texture != 0 && --fontTextureUsers[texture] == 0)
+				fontTextureUsers.erase(texture);
+#endif
+			delete (CIw2DFont*)r.data;
 		}
-		i++;
 	}
-	return NULL;
+	r.data = NULL;
+	r.bytes = 0;
 }
 
-void* IGResourceManager::free(std::string name) {
-	void* ret = NULL;
-	std::vector<IGResourceManager::Resource*>::iterator i = resources.begin();
-	while(i!=resources.end()) {
-		IGResourceManager::Resource* r = *i;
-		if(r->name == name) {
-			// found the resource
-			r->count--;
-			if(r->count == 0) {
-				ret = r->data;
-				i = resources.erase(i);
-				delete r;
-			}
-			break;
+int IGResourceManager::find(const char* name, unsigned int hash) {
+	if(table.empty())
+		return -1;
+	// open addressing, linear probing
+	unsigned int mask = table.size() - 1;
+	for(unsigned int slot = hash & mask; ; slot = (slot + 1) & mask) {
+		int index = table[slot];
+		if(index < 0)
+			return -1;
+		if(resources[index].hash == hash && resources[index].name == name)
+			return index;
+	}
+}
+
+IGResourceId IGResourceManager::getId(const char* name) {
+	unsigned int hash = IGHashString(name);
+	int index = find(name, hash);
+	if(index >= 0)
+		return index;
+
+	// keep the table at most half full
+	if((resources.size() + 1) * 2 > table.size()) {
+		std::vector<int> old;
+		old.swap(table);
+		table.assign(old.empty() ? 64 : old.size() * 2, -1);
+		unsigned int mask = table.size() - 1;
+		for(unsigned int i=0; i<resources.size(); i++) {
+			unsigned int slot = resources[i].hash & mask;
+			while(table[slot] >= 0)
+				slot = (slot + 1) & mask;
+			table[slot] = i;
 		}
-		i++;
 	}
-	return ret;
+
+	IGResourceManager::Resource r;
+	r.name = name;
+	r.hash = hash;
+	r.data = NULL;
+	r.count = 0;
+	r.bytes = 0;
+	r.type = IGResourceManagerTypeImage;
+	r.lruPrev = r.lruNext = -1;
+	index = resources.size();
+	resources.push_back(r);
+
+	unsigned int mask = table.size() - 1;
+	unsigned int slot = hash & mask;
+	while(table[slot] >= 0)
+		slot = (slot + 1) & mask;
+	table[slot] = index;
+	return index;
+}
+
+void IGResourceManager::lruRemove(int index) {
+	IGResourceManager::Resource& r = resources[index];
+	if(r.lruPrev >= 0)
+		resources[r.lruPrev].lruNext = r.lruNext;
+	else
+		lruHead = r.lruNext;
+	if(r.lruNext >= 0)
+		resources[r.lruNext].lruPrev = r.lruPrev;
+	else
+		lruTail = r.lruPrev;
+	r.lruPrev = r.lruNext = -1;
+}
+
+void IGResourceManager::lruPush(int index) {
+	IGResourceManager::Resource& r = resources[index];
+	r.lruPrev = -1;
+	r.lruNext = lruHead;
+	if(lruHead >= 0)
+		resources[lruHead].lruPrev = index;
+	lruHead = index;
+	if(lruTail < 0)
+		lruTail = index;
+}
+
+void IGResourceManager::trim(unsigned int budget) {
+	// evict the least recently released first (a zero budget drops everything unused)
+	while(lruTail >= 0 && (unusedBytes > budget || budget == 0)) {
+		int index = lruTail;
+		lruRemove(index);
+		unusedBytes -= resources[index].bytes;
+		unload(resources[index]);
+	}
 }
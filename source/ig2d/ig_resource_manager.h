@@ -4,6 +4,7 @@
 
 #include "Iw2D.h"
 #include "ig_global.h"
+#include <map>
 #include <string>
 #include <vector>
 
@@ -12,6 +13,10 @@ typedef enum {
 	IGResourceManagerTypeFont = 1,
 } IGResourceManagerType;
 
+// interned resource name, valid for as long as the manager lives
+typedef uint32 IGResourceId;
+static const IGResourceId IGResourceNone = 0xffffffff;
+
 class IGResourceManager {
 public:
 	// return the instance
@@ -22,12 +27,24 @@ public:
 	~IGResourceManager();
 	static void shutdown();
 
+	// intern a resource name
+	IGResourceId getId(const char* name);
+	const char* getName(IGResourceId id);
+
 	// get and free resources
-	CIw2DImage* getImage(std::string name);
-	CIw2DFont* getFont(std::string name);
-	void freeImage(std::string name);
-	void freeFont(std::string name);
+	CIw2DImage* getImage(IGResourceId id);
+	CIw2DFont* getFont(IGResourceId id);
+	void freeImage(IGResourceId id);
+	void freeFont(IGResourceId id);
 	void freeAllResources();
+
+	// unused resources are kept until they take more than the budget (in bytes)
+	void setMemoryBudget(unsigned int bytes);
+	void purgeUnused();
+
+	// background loading of a resource group
+	void preloadGroup(const char* group);
+	float getGroupProgress(const char* group);
 	
 private:
 	static IGResourceManager* instance;
@@ -35,17 +52,34 @@ private:
 	// a resource
 	struct Resource {
 		std::string name;
+		unsigned int hash;
 		void* data;
 		unsigned int count;
+		unsigned int bytes;
 		short int type;
+		int lruPrev, lruNext;
 	};
 	
-	// list of resources
-	std::vector<IGResourceManager::Resource*> resources;
+	// resources, indexed by the name table
+	std::vector<IGResourceManager::Resource> resources;
+	std::vector<int> table;
+
+	// unused resources, most recently released first
+	int lruHead, lruTail;
+	unsigned int unusedBytes, memoryBudget;
+
+	// fonts loaded on each font texture; only the first one is charged for it
+	std::map<uint32, unsigned int> fontTextureUsers;
 	
 	// load a resource
-	void* getResource(std::string name);
-	void* free(std::string name);
+	void* getResource(IGResourceId id, short int type);
+	void free(IGResourceId id);
+	void* load(Resource& r);
+	void unload(Resource& r);
+	int find(const char* name, unsigned int hash);
+	void lruRemove(int index);
+	void lruPush(int index);
+	void trim(unsigned int budget);
 };
 
-#endif // IG_RESOURCE_MANAGER_H
\ No newline at end of file
+#endif // IG_RESOURCE_MANAGER_H
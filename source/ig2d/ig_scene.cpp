@@ -4,7 +4,19 @@
 #include "IwResManager.h"
 
 IGScene::IGScene() {
-	IGScene::unloadResources();
+	// resources of the outgoing scene are not unloaded here: the incoming
+	// scene is built while the old one still holds its references, so
+	// shared art stays resident and the rest is left to the resource
+	// manager's unused list. The director destroys the groups only the
+	// old scene used once it is gone.
+	numGroups = 0;
+
+	// scenes dispatch touches through a hit-test grid
+	useTouchGrid();
+}
+
+const char* IGScene::className() {
+	return "IGScene";
 }
 
 void IGScene::unloadResources() {
@@ -19,6 +31,39 @@ void IGScene::unloadResources() {
 	IGResourceManager::getInstance()->freeAllResources();
 }
 
+void IGScene::loadGroup(const char* name) {
+	CIwResGroup* group = IwGetResManager()->GetGroupNamed(name, IW_RES_PERMIT_NULL_F);
+	if(group != NULL)
+		IwGetResManager()->SetCurrentGroup(group);
+	else {
+		IwGetResManager()->LoadGroup(name);
+		group = IwGetResManager()->GetGroupNamed(name, IW_RES_PERMIT_NULL_F);
+	}
+
+	// compat has no group objects, its groups cost nothing to keep
+	if(group != NULL && numGroups < IG_SCENE_MAX_GROUPS)
+		groups[numGroups++] = group;
+}
+
+bool IGScene::usesGroup(CIwResGroup* group) {
+	for(int i=0; i<numGroups; i++)
+		if(groups[i] == group)
+			return true;
+	return false;
+}
+
+bool IGScene::unloadGroups(IGScene* scene) {
+	bool unloaded = false;
+	for(int i=IwGetResManager()->GetNumGroups()-1; i>=0; i--) {
+		CIwResGroup* group = IwGetResManager()->GetGroup(i);
+		if(scene == NULL || !scene->usesGroup(group)) {
+			IwGetResManager()->DestroyGroup(group);
+			unloaded = true;
+		}
+	}
+	return unloaded;
+}
+
 void IGScene::display() {
 	// clear the screen
 	Iw2DClearScreen(IGDistorter::getInstance()->colorBlackInt);
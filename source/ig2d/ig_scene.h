@@ -4,11 +4,29 @@
 
 #include "ig_node.h"
 
+#define IG_SCENE_MAX_GROUPS 4
+
+struct CIwResGroup;
+
 class IGScene: public IGNode {
 public:
 	IGScene();
 	static void unloadResources();
+	// destroy the resource groups the scene doesn't use, all of them
+	// for none; returns whether any went
+	static bool unloadGroups(IGScene* scene);
 	virtual void display();
+	virtual const char* className();
+
+protected:
+	// load a resource group for the scene, or make it current again if
+	// the outgoing scene still has it loaded
+	void loadGroup(const char* name);
+
+private:
+	CIwResGroup* groups[IG_SCENE_MAX_GROUPS];
+	int numGroups;
+	bool usesGroup(CIwResGroup* group);
 };
 
 #endif // IG_SCENE_H
\ No newline at end of file
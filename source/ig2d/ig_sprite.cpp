@@ -1,8 +1,12 @@
 #include "ig_sprite.h"
 #include "ig_resource_manager.h"
 #include "ig_distorter.h"
+#include "ig_director.h"
+#include "ig_profiler.h"
+#include "ig_tween.h"
 
 IGSprite::IGSprite() {
+	imageId = IGResourceNone;
 	image = NULL;
 	position = IGPoint();
 	size = IGRect();
@@ -12,9 +16,9 @@ IGSprite::IGSprite() {
 }
 
 IGSprite::IGSprite(const IGSprite& s) {
-	imageName = s.imageName;
+	imageId = s.imageId;
 	image = s.image;
-	position = IGPoint(s.position);
+	position = previousPosition = IGPoint(s.position);
 	size = IGRect(s.size);
 	z = s.z;
 	tag = s.tag;
@@ -22,8 +26,8 @@ IGSprite::IGSprite(const IGSprite& s) {
 }
 
 IGSprite::IGSprite(const char *resource, IGPoint _position, int _z, int _tag) {
-	imageName = std::string(resource);
-	image = IGResourceManager::getInstance()->getImage(imageName);
+	imageId = IGResourceManager::getInstance()->getId(resource);
+	image = IGResourceManager::getInstance()->getImage(imageId);
 	this->set(_position, IGRect(image->GetWidth(), image->GetHeight()));
 	z = _z;
 	tag = _tag;
@@ -31,8 +35,8 @@ IGSprite::IGSprite(const char *resource, IGPoint _position, int _z, int _tag) {
 }
 
 IGSprite::IGSprite(const char *resource, IGPoint _position, IGRect _size, int _z, int _tag) {
-	imageName = std::string(resource);
-	image = IGResourceManager::getInstance()->getImage(imageName);
+	imageId = IGResourceManager::getInstance()->getId(resource);
+	image = IGResourceManager::getInstance()->getImage(imageId);
 	this->set(_position, _size);
 	z = _z;
 	tag = _tag;
@@ -41,7 +45,11 @@ IGSprite::IGSprite(const char *resource, IGPoint _position, IGRect _size, int _z
 
 IGSprite::~IGSprite() {
 	if(image != NULL)
-		IGResourceManager::getInstance()->freeImage(imageName);
+		IGResourceManager::getInstance()->freeImage(imageId);
+}
+
+const char* IGSprite::className() {
+	return "IGSprite";
 }
 
 void IGSprite::set(IGPoint _position) {
@@ -50,12 +58,17 @@ void IGSprite::set(IGPoint _position) {
 
 void IGSprite::set(IGPoint _position, IGRect _size) {
 	position = IGPoint(_position);
+	previousPosition = position; // placed, not moved
 	size = IGRect(_size);
+	invalidateTouch();
+	IGDirector::getInstance()->invalidate();
 }
 
 void IGSprite::setColor(uint8 r, uint8 g, uint8 b, uint8 a) {
 	CIwColour c = CIwColour();
 	c.Set(r, g, b, a);
+	if(color != c.Get())
+		IGDirector::getInstance()->invalidate();
 	color = c.Get();
 }
 
@@ -63,23 +76,67 @@ void IGSprite::setOpacity(uint8 opacity) {
 	setColor(255, 255, 255, opacity);
 }
 
+void IGSprite::tween(int property, float value) {
+	switch(property) {
+		case IGTweenX:
+			if(position.x != value)
+				IGDirector::getInstance()->invalidate();
+			position.x = value;
+			break;
+		case IGTweenY:
+			if(position.y != value)
+				IGDirector::getInstance()->invalidate();
+			position.y = value;
+			break;
+		case IGTweenOpacity: {
+			// keep the tint, labels are not always white
+			CIwColour c = CIwColour();
+			c.Set(color);
+			setColor(c.r, c.g, c.b, (uint8)value);
+			break;
+		}
+	}
+}
+
 void IGSprite::changeImage(const char *resource) {
+	changeImage(IGResourceManager::getInstance()->getId(resource));
+}
+
+void IGSprite::changeImage(IGResourceId resource) {
+	if(image != NULL && resource == imageId)
+		return;
 	if(image != NULL)
-		IGResourceManager::getInstance()->freeImage(imageName);
-	imageName = std::string(resource);
-	image = IGResourceManager::getInstance()->getImage(imageName);
+		IGResourceManager::getInstance()->freeImage(imageId);
+	imageId = resource;
+	image = IGResourceManager::getInstance()->getImage(imageId);
 	this->set(position, IGRect(image->GetWidth(), image->GetHeight()));
 }
 
+void IGSprite::snapshot() {
+	// moved during the last tick: the next frame still has to show where it ended
+	if(previousPosition.x != position.x || previousPosition.y != position.y)
+		IGDirector::getInstance()->invalidate();
+	previousPosition = position;
+	IGNode::snapshot();
+}
+
+IGPoint IGSprite::displayPosition() {
+	float t = IGDirector::getInstance()->interpolation;
+	return IGPoint(previousPosition.x + (position.x-previousPosition.x)*t,
+		previousPosition.y + (position.y-previousPosition.y)*t);
+}
+
 void IGSprite::display() {
 	if(image != NULL) {
 		// set the opacity
 		Iw2DSetColour(color);
 		
 		// display the image
+		IGPoint p = displayPosition();
+		IG_PROFILE("Iw2DDrawImage");
 		Iw2DDrawImage(image,
-			CIwSVec2((int)((position.x-size.width/2)+IGDistorter::getInstance()->offsetX), 
-				(int)((position.y-size.height/2)+IGDistorter::getInstance()->offsetY)),
+			CIwSVec2((int)((p.x-size.width/2)+IGDistorter::getInstance()->offsetX), 
+				(int)((p.y-size.height/2)+IGDistorter::getInstance()->offsetY)),
 			CIwSVec2((int)size.width, (int)size.height));
 	}
 }
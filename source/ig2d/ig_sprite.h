@@ -6,14 +6,15 @@
 #include "ig_global.h"
 #include "ig_distorter.h"
 #include "ig_node.h"
-#include <string>
+#include "ig_resource_manager.h"
 
 class IGSprite: public IGNode {
 public:
 	CIw2DImage* image;
 	IGPoint position;
+	IGPoint previousPosition; // at the last update, for interpolation
 	IGRect size;
-	std::string imageName;
+	IGResourceId imageId;
 	
 	// constructor and destructor
 	IGSprite();
@@ -28,9 +29,14 @@ public:
 	void setColor(uint8 r, uint8 g, uint8 b, uint8 a);
 	void setOpacity(uint8 opacity);
 	void changeImage(const char *resource);
+	void changeImage(IGResourceId resource);
 	
 	// display
 	virtual void display();
+	virtual const char* className();
+	virtual void snapshot();
+	virtual void tween(int property, float value);
+	IGPoint displayPosition();
 	
 protected:
 	uint32 color;
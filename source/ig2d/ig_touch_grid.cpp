@@ -0,0 +1,119 @@
+#include "ig_touch_grid.h"
+#include "ig_node.h"
+#include "ig_distorter.h"
+
+#define IG_TOUCH_GRID_CELL 40
+
+IGTouchGrid::IGTouchGrid(IGNode* _owner) {
+	owner = _owner;
+	dirty = true;
+	pressed = NULL;
+	left = top = 0;
+	cellWidth = cellHeight = IG_TOUCH_GRID_CELL;
+	columns = rows = 0;
+}
+
+void IGTouchGrid::invalidate() {
+	dirty = true;
+}
+
+void IGTouchGrid::forget(IGNode* node) {
+	if(pressed == node)
+		pressed = NULL;
+	dirty = true;
+}
+
+void IGTouchGrid::rebuild() {
+	owner->sortChildren();
+	cells.clear();
+	everywhere.clear();
+
+	// bounds of all touch areas
+	float right = 0, bottom = 0;
+	bool first = true;
+	IGPoint center;
+	IGRect area;
+	for(unsigned int i=0; i<owner->children.size(); i++) {
+		if(!owner->children[i]->touchArea(center, area))
+			continue;
+		float x1 = center.x - area.width/2, y1 = center.y - area.height/2;
+		float x2 = center.x + area.width/2, y2 = center.y + area.height/2;
+		if(first || x1 < left) left = x1;
+		if(first || y1 < top) top = y1;
+		if(first || x2 > right) right = x2;
+		if(first || y2 > bottom) bottom = y2;
+		first = false;
+	}
+	columns = first ? 0 : (int)((right - left) / cellWidth) + 1;
+	rows = first ? 0 : (int)((bottom - top) / cellHeight) + 1;
+	cells.resize(columns * rows);
+
+	// children are visited in z order, so every cell stays sorted
+	for(unsigned int i=0; i<owner->children.size(); i++) {
+		IGNode* node = owner->children[i];
+		if(node->touchArea(center, area)) {
+			int c1 = (int)((center.x - area.width/2 - left) / cellWidth);
+			int c2 = (int)((center.x + area.width/2 - left) / cellWidth);
+			int r1 = (int)((center.y - area.height/2 - top) / cellHeight);
+			int r2 = (int)((center.y + area.height/2 - top) / cellHeight);
+			for(int r=r1; r<=r2 && r<rows; r++)
+				for(int c=c1; c<=c2 && c<columns; c++)
+					cells[r*columns+c].push_back(i);
+		} else if(node->isTouchable()) {
+			everywhere.push_back(i);
+		}
+	}
+	dirty = false;
+}
+
+int IGTouchGrid::cellAt(float x, float y) {
+	if(x < left || y < top)
+		return -1;
+	int c = (int)((x - left) / cellWidth);
+	int r = (int)((y - top) / cellHeight);
+	if(c >= columns || r >= rows)
+		return -1;
+	return r*columns+c;
+}
+
+bool IGTouchGrid::touch(s3ePointerTouchEvent* event) {
+	if(dirty)
+		rebuild();
+
+	float x = IGDistorter::getInstance()->distortBackX((float)event->m_x);
+	float y = IGDistorter::getInstance()->distortBackY((float)event->m_y);
+	int cell = cellAt(x, y);
+	static const std::vector<int> none;
+	const std::vector<int>& hits = cell < 0 ? none : cells[cell];
+
+	// a child pressed earlier and not under the touch now still gets it, to let go
+	if(pressed != NULL) {
+		bool under = false;
+		for(unsigned int i=0; i<hits.size() && !under; i++)
+			under = (owner->children[hits[i]] == pressed);
+		IGNode* node = pressed;
+		if(!event->m_Pressed)
+			pressed = NULL;
+		if(!under)
+			node->touch(event);
+	}
+
+	// merge both lists, keeping z order
+	unsigned int h = 0, e = 0;
+	while(h < hits.size() || e < everywhere.size()) {
+		int index;
+		if(e >= everywhere.size() || (h < hits.size() && hits[h] < everywhere[e]))
+			index = hits[h++];
+		else
+			index = everywhere[e++];
+		IGNode* node = owner->children[index];
+		IGNode* wasPressed = pressed;
+		if(event->m_Pressed)
+			pressed = node;
+		// the handler may have replaced the whole scene, so leave right away
+		if(node->touch(event))
+			return true;
+		pressed = wasPressed;
+	}
+	return false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef IG_TOUCH_GRID_H
+#define IG_TOUCH_GRID_H
+
+#include <vector>
+#include "s3e.h"
+#include "ig_global.h"
+
+class IGNode;
+
+// hit-test grid over the children of a node, so a touch is only
+// passed to the children whose touch area covers it
+class IGTouchGrid {
+public:
+	IGTouchGrid(IGNode* _owner);
+
+	// children were added, removed, moved or re-sorted
+	void invalidate();
+	void forget(IGNode* node);
+
+	// pass a touch to the children, return true if handled
+	bool touch(s3ePointerTouchEvent* event);
+
+private:
+	IGNode* owner;
+	bool dirty;
+	IGNode* pressed; // last child that took a touch down
+
+	// grid over the bounds of all touch areas
+	float left, top, cellWidth, cellHeight;
+	int columns, rows;
+	std::vector< std::vector<int> > cells; // child indices, in z order
+	std::vector<int> everywhere; // touchable children without an area
+
+	void rebuild();
+	int cellAt(float x, float y);
+};
+
+#endif // IG_TOUCH_GRID_H
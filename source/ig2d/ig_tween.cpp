@@ -0,0 +1,154 @@
+#include "ig_tween.h"
+#include "ig_node.h"
+#include "ig_director.h"
+
+IGTweens* IGTweens::instance = NULL;
+
+IGTweens* IGTweens::getInstance() {
+	if(instance == NULL)
+		instance = new IGTweens();
+	return instance;
+}
+
+IGTweens::IGTweens() {
+	updating = false;
+}
+
+void IGTweens::shutdown() {
+	if(instance != NULL)
+		delete instance;
+	instance = NULL;
+}
+
+void IGTweens::add(IGNode* node, int property, float from, float to, int32 duration, int32 delay, int easing, bool loop) {
+	cancel(node, property);
+	Tween t;
+	t.node = node;
+	t.from = from;
+	t.to = to;
+	t.time = 0;
+	t.duration = duration;
+	t.delay = delay;
+	t.property = (int16)property;
+	t.easing = (int16)easing;
+	t.loop = loop;
+	tweens.push_back(t);
+	if(delay <= 0)
+		node->tween(property, from);
+	IGDirector::getInstance()->keepAwake();
+}
+
+void IGTweens::then(IGNode* node, int property, float to, int32 duration, int32 delay, int easing) {
+	Tween* last = NULL;
+	int32 left = 0;
+	for(unsigned int i=0; i<tweens.size(); i++) {
+		Tween& t = tweens[i];
+		if(t.node == node && t.property == property && !t.loop && t.delay+t.duration-t.time >= left) {
+			last = &t;
+			left = t.delay+t.duration-t.time;
+		}
+	}
+	if(last == NULL) {
+		add(node, property, to, to, 0, delay, easing);
+		return;
+	}
+	Tween t = *last;
+	t.from = last->to;
+	t.to = to;
+	t.time = 0;
+	t.duration = duration;
+	t.delay = left+delay;
+	t.easing = (int16)easing;
+	tweens.push_back(t);
+}
+
+void IGTweens::cancel(IGNode* node) {
+	for(unsigned int i=0; i<tweens.size(); i++)
+		if(tweens[i].node == node)
+			tweens[i].node = NULL;
+	if(!updating)
+		compact();
+}
+
+void IGTweens::cancel(IGNode* node, int property) {
+	for(unsigned int i=0; i<tweens.size(); i++)
+		if(tweens[i].node == node && tweens[i].property == property)
+			tweens[i].node = NULL;
+}
+
+bool IGTweens::isActive(IGNode* node) {
+	for(unsigned int i=0; i<tweens.size(); i++)
+		if(tweens[i].node == node)
+			return true;
+	return false;
+}
+
+bool IGTweens::isActive(IGNode* node, int property) {
+	for(unsigned int i=0; i<tweens.size(); i++)
+		if(tweens[i].node == node && tweens[i].property == property)
+			return true;
+	return false;
+}
+
+void IGTweens::forget(IGNode* node) {
+	if(instance != NULL)
+		instance->cancel(node);
+}
+
+float IGTweens::ease(int easing, float t) {
+	switch(easing) {
+		case IGEaseIn: return t*t;
+		case IGEaseOut: return 1-(1-t)*(1-t);
+		case IGEaseInOut: return t*t*(3-2*t);
+	}
+	return t;
+}
+
+void IGTweens::update(int32 ms) {
+	// tweens added while walking the array wait for the next tick
+	updating = true;
+	unsigned int count = tweens.size();
+	for(unsigned int i=0; i<count; i++) {
+		Tween& t = tweens[i];
+		if(t.node == NULL)
+			continue;
+		t.time += ms;
+		if(t.time < t.delay)
+			continue;
+		int32 elapsed = t.time - t.delay;
+		bool done = false;
+		if(elapsed >= t.duration) {
+			if(t.loop && t.duration > 0) {
+				elapsed %= t.duration;
+				t.time = t.delay + elapsed;
+			} else {
+				elapsed = t.duration;
+				done = true;
+			}
+		}
+		float k = t.duration > 0 ? ease(t.easing, (float)elapsed/t.duration) : 1.0f;
+		float value = t.from + (t.to-t.from)*k;
+
+		// the node may add tweens, which can move the array
+		IGNode* node = t.node;
+		int property = t.property;
+		if(done)
+			t.node = NULL;
+		node->tween(property, value);
+	}
+	updating = false;
+	compact();
+
+	if(!tweens.empty())
+		IGDirector::getInstance()->keepAwake();
+}
+
+// finished and cancelled tweens lose their node, the array is
+// closed up once nobody is walking it
+void IGTweens::compact() {
+	unsigned int kept = 0;
+	for(unsigned int i=0; i<tweens.size(); i++)
+		if(tweens[i].node != NULL)
+			tweens[kept++] = tweens[i];
+	tweens.resize(kept);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef IG_TWEEN_H
+#define IG_TWEEN_H
+
+#include <vector>
+#include "s3e.h"
+
+class IGNode;
+
+// what a tween drives, passed to IGNode::tween
+typedef enum {
+	IGTweenX = 0,
+	IGTweenY = 1,
+	IGTweenOpacity = 2,
+	IGTweenFrame = 3,
+	IGTweenUser = 16 // nodes number their own properties from here
+} IGTweenProperty;
+
+typedef enum {
+	IGEaseLinear = 0,
+	IGEaseIn = 1,
+	IGEaseOut = 2,
+	IGEaseInOut = 3
+} IGTweenEasing;
+
+// every running tween in one flat array, advanced once per tick by the
+// director, so nodes never look at the clock themselves; nodes invalidate
+// the frame in tween() when the value changes what they draw
+class IGTweens {
+public:
+	static IGTweens* getInstance();
+	static void shutdown();
+
+	// replaces a tween already running on the same node and property,
+	// the value is set to from right away unless there is a delay
+	void add(IGNode* node, int property, float from, float to, int32 duration, int32 delay=0, int easing=IGEaseOut, bool loop=false);
+	// queue another tween after the ones running on the same node and
+	// property, starting from where they end (with none it just sets to)
+	void then(IGNode* node, int property, float to, int32 duration, int32 delay=0, int easing=IGEaseOut);
+	void cancel(IGNode* node);
+	void cancel(IGNode* node, int property);
+	bool isActive(IGNode* node);
+	bool isActive(IGNode* node, int property);
+
+	// advance everything by one tick
+	void update(int32 ms);
+
+	// deleted nodes drop their tweens, safe to call with no instance
+	static void forget(IGNode* node);
+
+private:
+	struct Tween {
+		IGNode* node;
+		float from, to;
+		int32 time, duration, delay;
+		int16 property, easing;
+		bool loop;
+	};
+	std::vector<Tween> tweens;
+	bool updating; // nodes may add or cancel tweens from tween()
+
+	IGTweens();
+	void compact();
+	static float ease(int easing, float t);
+	static IGTweens* instance;
+};
+
+#endif // IG_TWEEN_H
@@ -1,6 +1,8 @@
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "s3e.h"
+#include "s3eSound.h"
 #include "IwGx.h"
 #include "Iw2D.h"
 #include "IwResManager.h"
@@ -9,6 +11,8 @@
 #include "scene_game.h"
 #include "scene_game_menu.h"
 #include "scene_menu.h"
+#include "scene_map.h"
+#include "scene_select_level.h"
 #include "derbh.h"
 #include "settings.h"
 #include "sounds.h"
@@ -17,12 +21,51 @@
 #include "leadersboard.h"
 #include "config.h"
 #include "debug_ui.h"
+#ifndef __S3E__
+#include "dgreed/async.h"
+#endif
 
 // How big a tick difference is considered 'time warp', i.e. skip the time
 // (to avoid physics blowing up)
 #define TICK_TIMEWARP 1000
-// attempt to lock frame rate to 30 fps
-#define	MS_PER_FRAME (1000 / 30)
+// the game logic runs at a fixed 30 ticks per second
+#define	MS_PER_TICK (1000 / 30)
+// rendering runs up to 60 fps, interpolating between ticks
+#define	MS_PER_FRAME (1000 / 60)
+// without input for a while, draw at a low-power rate
+#define	MS_PER_IDLE_FRAME (1000 / 10)
+#define IDLE_AFTER_MS 10000
+// with nothing animating, sleep until input (or a slow poll)
+#define IDLE_WAKE_MS 250
+
+// frame time histogram, 1 ms buckets
+#define FRAME_HISTOGRAM_SIZE 100
+static uint32 frameHistogram[FRAME_HISTOGRAM_SIZE + 1];
+static uint32 frameHistogramCount = 0;
+
+void frameHistogramAdd(int32 ms) {
+	if(ms < 0)
+		ms = 0;
+	frameHistogram[ms < FRAME_HISTOGRAM_SIZE ? ms : FRAME_HISTOGRAM_SIZE]++;
+	frameHistogramCount++;
+}
+
+void frameHistogramReport() {
+	if(frameHistogramCount == 0)
+		return;
+	// percentiles, then the non-empty buckets
+	const int percents[] = { 50, 90, 95, 99, 100 };
+	for(unsigned int p=0; p<sizeof(percents)/sizeof(percents[0]); p++) {
+		uint32 want = (uint32)(((uint64)frameHistogramCount * percents[p] + 99) / 100), seen = 0;
+		int ms = 0;
+		while(ms < FRAME_HISTOGRAM_SIZE && (seen += frameHistogram[ms]) < want)
+			ms++;
+		fprintf(stderr, "frame time p%d: %s%d ms\n", percents[p], ms == FRAME_HISTOGRAM_SIZE ? ">=" : "", ms);
+	}
+	for(int ms=0; ms<=FRAME_HISTOGRAM_SIZE; ms++)
+		if(frameHistogram[ms])
+			fprintf(stderr, "frame time %s%3d ms: %u\n", ms == FRAME_HISTOGRAM_SIZE ? ">=" : "  ", ms, frameHistogram[ms]);
+}
 
 // airplay callbacks
 int32 callbackPause(void* systemData, void* userData) {
@@ -124,6 +167,8 @@ void gameStart() {
 }
 
 void gameShutdown() {
+	frameHistogramReport();
+
 	// unload all extra resource groups
 	IGScene::unloadResources();
 
@@ -131,9 +176,17 @@ void gameShutdown() {
 	s3eDeviceUnRegister(S3E_DEVICE_PAUSE, callbackPause);
 	s3eDeviceUnRegister(S3E_DEVICE_UNPAUSE, callbackUnpause);
 
+#ifdef IG_PROFILER
+	// the last frames, for a spreadsheet and for chrome://tracing
+	IGProfiler::getInstance()->dumpCSV("profile.csv");
+	IGProfiler::getInstance()->dumpTrace("profile.json");
+	IGProfiler::shutdown();
+#endif
+
 	// shutdown everything else
 	touchesShutdown();
 	IGDirector::shutdown();
+	IGTweens::shutdown();
 	IGDistorter::shutdown();
 	IGResourceManager::shutdown();
 	Settings::shutdown();
@@ -158,6 +211,196 @@ void gameJustGenerateTextures() {
 	IwGetResManager()->LoadGroup("select_level.group");
 }
 
+// scene transition timing: first round is cold, the rest show what stays resident
+#define BENCHMARK_TRANSITION_ROUNDS 5
+#define BENCHMARK_TRANSITION_SCENES 5
+
+static IGScene* gameBenchmarkScene(int i) {
+	switch(i) {
+	case 0: return new SceneMenu();
+	case 1: return new SceneMap();
+	case 2: return new SceneSelectLevel();
+	case 3: return new SceneGame();
+	default: return new SceneGameMenu();
+	}
+}
+
+void gameBenchmarkTransitions() {
+	const char* names[BENCHMARK_TRANSITION_SCENES] = { "menu", "map", "select-level", "game", "game-menu" };
+	uint64 total[BENCHMARK_TRANSITION_SCENES] = { 0 };
+	uint64 cold[BENCHMARK_TRANSITION_SCENES] = { 0 };
+	for(int round=0; round<BENCHMARK_TRANSITION_ROUNDS; round++) {
+		for(int i=0; i<BENCHMARK_TRANSITION_SCENES; i++) {
+			// time from building the scene to its first frame on screen
+			uint64 start = s3eTimerGetMs();
+			IGDirector::getInstance()->switchScene(gameBenchmarkScene(i));
+			IGDirector::getInstance()->display();
+			uint64 ms = s3eTimerGetMs() - start;
+			if(round == 0)
+				cold[i] = ms;
+			else
+				total[i] += ms;
+		}
+	}
+	for(int i=0; i<BENCHMARK_TRANSITION_SCENES; i++)
+		fprintf(stderr, "transition to %-12s cold %4d ms, warm %4d ms\n", names[i], (int)cold[i],
+			(int)(total[i] / (BENCHMARK_TRANSITION_ROUNDS - 1)));
+	GameData::getInstance()->activeGame = false;
+	IGDirector::getInstance()->switchScene(NULL);
+}
+
+// sound effect stress: bursts of every effect, far more than there are
+// voices, so most plays go through voice stealing
+#define BENCHMARK_SOUND_PLAYS 5000
+
+void gameBenchmarkSounds() {
+	Sounds* sounds = Sounds::getInstance();
+	uint64 start = s3eTimerGetUSTNanoseconds();
+	for(int i=0; i<BENCHMARK_SOUND_PLAYS; i++) {
+		switch(i % 7) {
+		case 0: sounds->playKeyMove(); break;
+		case 1: sounds->playOpenChest(); break;
+		case 2: sounds->playRestartLevel(); break;
+		case 3: sounds->playDoor(); break;
+		case 4: sounds->playClick(); break;
+		case 5: sounds->playMapLocked(); break;
+		default: sounds->playUnlockAchievement(); break;
+		}
+	}
+	uint64 ns = s3eTimerGetUSTNanoseconds() - start;
+	fprintf(stderr, "%d sound plays in %d ms, %.1f us per play\n", BENCHMARK_SOUND_PLAYS, (int)(ns / 1000000),
+		ns / 1000.0 / BENCHMARK_SOUND_PLAYS);
+#ifndef __S3E__
+	s3eSoundBankStats stats;
+	s3eSoundBankGetStats(&stats);
+	fprintf(stderr, "%u played, %u stolen, %u dropped, %u of %u voices busy\n", stats.plays, stats.steals, stats.drops,
+		stats.busy, stats.voices);
+#endif
+	s3eSoundStopAllChannels();
+}
+
+// software mixer cost (compat with SK_SOUND=null): every effect started
+// again and again for BENCHMARK_MIXER_SECONDS, so all voices keep mixing
+#define BENCHMARK_MIXER_SECONDS 10
+#define BENCHMARK_MIXER_FRAMES 1024
+
+void gameBenchmarkMixer() {
+#ifndef __S3E__
+	static int16 out[BENCHMARK_MIXER_FRAMES];
+	if(s3eSoundMixerRender(out, 0) == S3E_RESULT_ERROR) {
+		fprintf(stderr, "the mixer benchmark needs SK_SOUND=null\n");
+		return;
+	}
+	Sounds* sounds = Sounds::getInstance();
+	const int blocks = 44100 * BENCHMARK_MIXER_SECONDS / BENCHMARK_MIXER_FRAMES;
+	uint64 ns = 0;
+	for(int i=0; i<blocks; i++) {
+		if(i % 8 == 0) {
+			sounds->playKeyMove();
+			sounds->playOpenChest();
+			sounds->playRestartLevel();
+			sounds->playDoor();
+			sounds->playClick();
+			sounds->playMapLocked();
+			sounds->playUnlockAchievement();
+		}
+		uint64 start = s3eTimerGetUSTNanoseconds();
+		s3eSoundMixerRender(out, BENCHMARK_MIXER_FRAMES);
+		ns += s3eTimerGetUSTNanoseconds() - start;
+	}
+	fprintf(stderr, "%d s of sound mixed in %d ms, %.1f ns per frame\n", BENCHMARK_MIXER_SECONDS, (int)(ns / 1000000),
+		(double)ns / ((uint64)blocks * BENCHMARK_MIXER_FRAMES));
+	s3eSoundStopAllChannels();
+#endif
+}
+
+// task scheduler overhead (compat): tiny tasks, first all from the main
+// thread, then fanned out as children from inside a hundred parents, then
+// the timer wheel
+#define BENCHMARK_ASYNC_TASKS 100000
+#define BENCHMARK_ASYNC_PARENTS 100
+
+#ifndef __S3E__
+static volatile int benchmarkAsyncCount;
+
+static void gameBenchmarkAsyncTask(void*) {
+	__sync_fetch_and_add(&benchmarkAsyncCount, 1);
+}
+
+static void gameBenchmarkAsyncParent(void*) {
+	for(int i=0; i<BENCHMARK_ASYNC_TASKS / BENCHMARK_ASYNC_PARENTS; i++)
+		async_run_child(gameBenchmarkAsyncTask, NULL);
+}
+#endif
+
+void gameBenchmarkAsync() {
+#ifndef __S3E__
+	static TaskId ids[BENCHMARK_ASYNC_TASKS];
+	benchmarkAsyncCount = 0;
+	uint64 start = s3eTimerGetUSTNanoseconds();
+	for(int i=0; i<BENCHMARK_ASYNC_TASKS; i++)
+		ids[i] = async_run(gameBenchmarkAsyncTask, NULL);
+	for(int i=0; i<BENCHMARK_ASYNC_TASKS; i++)
+		while(!async_is_finished(ids[i]));
+	uint64 ns = s3eTimerGetUSTNanoseconds() - start;
+	fprintf(stderr, "%d flat tasks in %d ms, %.1f ns per task\n", benchmarkAsyncCount, (int)(ns / 1000000),
+		(double)ns / BENCHMARK_ASYNC_TASKS);
+
+	// a parent only finishes with its children, so waiting on the parents is enough
+	benchmarkAsyncCount = 0;
+	start = s3eTimerGetUSTNanoseconds();
+	for(int i=0; i<BENCHMARK_ASYNC_PARENTS; i++)
+		ids[i] = async_run(gameBenchmarkAsyncParent, NULL);
+	for(int i=0; i<BENCHMARK_ASYNC_PARENTS; i++)
+		while(!async_is_finished(ids[i]));
+	ns = s3eTimerGetUSTNanoseconds() - start;
+	fprintf(stderr, "%d child tasks in %d ms, %.1f ns per task\n", benchmarkAsyncCount, (int)(ns / 1000000),
+		(double)ns / (BENCHMARK_ASYNC_TASKS + BENCHMARK_ASYNC_PARENTS));
+
+	// timers spread over a minute, scheduled and cancelled again
+	start = s3eTimerGetUSTNanoseconds();
+	for(int i=0; i<BENCHMARK_ASYNC_TASKS; i++)
+		ids[i] = async_schedule(gameBenchmarkAsyncTask, (i * 7919) % 60000, NULL);
+	for(int i=0; i<BENCHMARK_ASYNC_TASKS; i++)
+		async_cancel(ids[i]);
+	ns = s3eTimerGetUSTNanoseconds() - start;
+	fprintf(stderr, "%d timers scheduled and cancelled in %d ms, %.1f ns per timer\n", BENCHMARK_ASYNC_TASKS,
+		(int)(ns / 1000000), (double)ns / BENCHMARK_ASYNC_TASKS);
+#endif
+}
+
+// benchmarks are picked by name with SK_BENCH (e.g. SK_BENCH=transitions);
+// the chosen one runs right after init and the game exits instead of starting
+struct GameBenchmark {
+	const char* name;
+	void (*run)();
+};
+
+static const GameBenchmark gameBenchmarks[] = {
+	{ "transitions", gameBenchmarkTransitions },
+	{ "sounds", gameBenchmarkSounds },		// needs sound enabled
+	{ "mixer", gameBenchmarkMixer },		// SK_SOUND=null, sound enabled
+	{ "async", gameBenchmarkAsync },		// compat only
+};
+
+static bool gameRunBenchmark() {
+	const char* name = getenv("SK_BENCH");
+	if(name == NULL)
+		return false;
+	const int count = sizeof(gameBenchmarks) / sizeof(gameBenchmarks[0]);
+	for(int i=0; i<count; i++) {
+		if(!strcmp(name, gameBenchmarks[i].name)) {
+			gameBenchmarks[i].run();
+			return true;
+		}
+	}
+	fprintf(stderr, "unknown benchmark %s, SK_BENCH is one of:", name);
+	for(int i=0; i<count; i++)
+		fprintf(stderr, " %s", gameBenchmarks[i].name);
+	fprintf(stderr, "\n");
+	return true;
+}
+
 int main(int argc, char* argv[]) {
 
 	time_t ts = time(NULL);
@@ -169,41 +412,84 @@ int main(int argc, char* argv[]) {
 	// uncomment to just generate textures and not load the game
 	// gameJustGenerateTextures(); return 0;
 
+	if(gameRunBenchmark()) {
+		gameShutdown();
+		return 0;
+	}
+
 	gameStart();
 	
 	// game loop
 	int32 frame = 0;
+	int64 last = s3eTimerGetMs();
+	int64 lastFrame = last;
+	int64 lag = 0;
 	while(1) { 
 		// let airplay do it's thing each frame
 		s3eDeviceYield(0); 
 		s3eKeyboardUpdate();
 		s3ePointerUpdate();
-		int64 start = s3eTimerGetMs();
-		
-		// update
-		frame++;
-		IGDirector::getInstance()->update();
 		if(s3eDeviceCheckQuitRequest())
 			break;
-		if(s3eKeyboardGetState(s3eKeyBack)&S3E_KEY_STATE_RELEASED)
+		if(s3eKeyboardGetState(s3eKeyBack)&S3E_KEY_STATE_RELEASED) {
+		  IGDirector::getInstance()->input();
 		  if(GameData::getInstance()->activeGame) {
 		    GameData::getInstance()->activeGame = false;
 		    IGDirector::getInstance()->switchScene(new SceneGameMenu());
 		  } else
 		    break; // quit
+		}
 
-		// render graphics
-		IGDirector::getInstance()->display();
-		display_debug_ui();
-		Iw2DSurfaceShow();
+		// run the ticks that are due, skipping a time warp (sleep, debugger)
+		int64 now = s3eTimerGetMs();
+		int64 elapsed = now - last;
+		last = now;
+		if(elapsed > TICK_TIMEWARP)
+			elapsed = MS_PER_TICK;
+		lag += elapsed;
+		while(lag >= MS_PER_TICK) {
+			frame++;
+			IGDirector::getInstance()->update(MS_PER_TICK);
+			lag -= MS_PER_TICK;
+		}
+
+#ifndef __S3E__
+		// scheduled tasks and continuations of finished background work
+		async_process_schedule();
+#endif
+
+		// render graphics, but only when something changed
+		int32 frameTime = (now - IGDirector::getInstance()->lastInput > IDLE_AFTER_MS) ? MS_PER_IDLE_FRAME : MS_PER_FRAME;
+		if(IGDirector::getInstance()->needsRedraw() && now - lastFrame >= frameTime) {
+			IGDirector::getInstance()->display((float)lag / MS_PER_TICK);
+			display_debug_ui();
+			Iw2DSurfaceShow();
+			frameHistogramAdd((int32)(now - lastFrame));
+			lastFrame = now;
+		}
 		
-		// attempt frame rate
-		while((s3eTimerGetMs() - start) < MS_PER_FRAME) {
-			int32 yield = (int32) (MS_PER_FRAME - (s3eTimerGetMs() - start));
-			if(yield < 0)
-				break;
-			s3eDeviceYield(yield);
+		// nothing to animate: block until input arrives, then run a
+		// single tick instead of catching up on the time slept
+		if(IGDirector::getInstance()->isIdle()) {
+			int32 idleWait = IDLE_WAKE_MS;
+#ifndef __S3E__
+			// but wake up in time for the next scheduled task
+			uint due = async_schedule_wait();
+			if(due < (uint)idleWait)
+				idleWait = (int32)due;
+#endif
+			s3eDeviceYieldUntilEvent(idleWait);
+			last = s3eTimerGetMs();
+			lag = MS_PER_TICK;
+			continue;
 		}
+
+		// sleep until the next tick or frame is due
+		int64 wait = MS_PER_TICK - lag;
+		if(lastFrame + frameTime - s3eTimerGetMs() < wait)
+			wait = lastFrame + frameTime - s3eTimerGetMs();
+		if(wait > 0)
+			s3eDeviceYield((int32)wait);
 	}
 	
 	// shutdown
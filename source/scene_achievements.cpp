@@ -7,10 +7,10 @@
 
 // menu button
 AchievementsButtonMenu::AchievementsButtonMenu() {
-	imageNormalName = std::string("achievements_menu");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("achievements_menu2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("achievements_menu");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("achievements_menu2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,452));
 	touchSize = IGRect(98,56);
@@ -27,10 +27,10 @@ void AchievementsButtonMenu::buttonReleased() {
 
 // back button
 AchievementsButtonBack::AchievementsButtonBack() {
-	imageNormalName = std::string("achievements_back");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("achievements_back2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("achievements_back");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("achievements_back2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(55,452));
 	touchSize = IGRect(111,56);
@@ -46,10 +46,10 @@ void AchievementsButtonBack::buttonReleased() {
 
 // next button
 AchievementsButtonNext::AchievementsButtonNext() {
-	imageNormalName = std::string("achievements_next");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("achievements_next2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("achievements_next");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("achievements_next2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(265,452));
 	touchSize = IGRect(111,56);
@@ -69,7 +69,7 @@ SceneAchievements::SceneAchievements() : IGScene()
 	IGLog("SceneAchievements init");
 	
 	// load the resources
-	IwGetResManager()->LoadGroup("achievements.group");
+	loadGroup("achievements.group");
 	
 	// the background
 	IGSprite* spriteBackground = new IGSprite("background_wood", IGPoint(160,240), 0);
@@ -98,6 +98,10 @@ SceneAchievements::SceneAchievements() : IGScene()
 	updateAchievements();
 }
 
+const char* SceneAchievements::className() {
+	return "SceneAchievements";
+}
+
 SceneAchievements::~SceneAchievements() {
 }
 
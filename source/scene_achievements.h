@@ -34,6 +34,7 @@ typedef enum {
 class SceneAchievements: public IGScene {
 public:
 	SceneAchievements();
+	const char* className();
 	~SceneAchievements();
 
 	AchievementsButtonBack* buttonBack;
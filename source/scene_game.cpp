@@ -13,10 +13,10 @@
 
 // menu button
 GameButtonMenu::GameButtonMenu() {
-	imageNormalName = std::string("game_menu");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(60,30));
 	touchSize = IGRect(110,60);
@@ -31,126 +31,217 @@ void GameButtonMenu::buttonReleased() {
 	IGDirector::getInstance()->switchScene(new SceneGameMenu());
 }
 
-// tile
-GameTile::GameTile(int _tileType, int _x, int _y, int _z, int _tag) {
-	tileType = _tileType;
-	imageName = getResourceName(tileType);
-	image = IGResourceManager::getInstance()->getImage(imageName);
-	this->changePosition(_x, _y);
+// tile art by stage and tile type (GameTileSpace has none)
+#define GAME_TILE_STAGES (GameStageShip+1)
+#define GAME_TILE_TYPES (GameTileDoorTBOpen+1)
+// ms for a key to slide one cell
+#define GAME_KEY_SLIDE_MS 60
+static const char* gameTileResources[GAME_TILE_STAGES][GAME_TILE_TYPES] = {
+	{
+		NULL,
+		"game_forest_4s", "game_forest_3s_trb", "game_forest_3s_trl", "game_forest_3s_tlb",
+		"game_forest_3s_rbl", "game_forest_2s_tr", "game_forest_2s_tb", "game_forest_2s_tl",
+		"game_forest_2s_rb", "game_forest_2s_rl", "game_forest_2s_bl", "game_forest_1s_t",
+		"game_forest_1s_r", "game_forest_1s_b", "game_forest_1s_l", "game_forest_0s",
+		"game_sprite_key", "game_sprite_chest_closed", "game_sprite_chest_open", "game_sprite_switch",
+		"game_sprite_door_lr_closed", "game_sprite_door_lr_open", "game_sprite_door_tb_closed", "game_sprite_door_tb_open"
+	},
+	{
+		NULL,
+		"game_caves_4s", "game_caves_3s_trb", "game_caves_3s_trl", "game_caves_3s_tlb",
+		"game_caves_3s_rbl", "game_caves_2s_tr", "game_caves_2s_tb", "game_caves_2s_tl",
+		"game_caves_2s_rb", "game_caves_2s_rl", "game_caves_2s_bl", "game_caves_1s_t",
+		"game_caves_1s_r", "game_caves_1s_b", "game_caves_1s_l", "game_caves_0s",
+		"game_sprite_key", "game_sprite_chest_closed", "game_sprite_chest_open", "game_sprite_switch",
+		"game_sprite_door_lr_closed", "game_sprite_door_lr_open", "game_sprite_door_tb_closed", "game_sprite_door_tb_open"
+	},
+	{
+		NULL,
+		"game_beach_4s", "game_beach_3s_trb", "game_beach_3s_trl", "game_beach_3s_tlb",
+		"game_beach_3s_rbl", "game_beach_2s_tr", "game_beach_2s_tb", "game_beach_2s_tl",
+		"game_beach_2s_rb", "game_beach_2s_rl", "game_beach_2s_bl", "game_beach_1s_t",
+		"game_beach_1s_r", "game_beach_1s_b", "game_beach_1s_l", "game_beach_0s",
+		"game_sprite_key", "game_sprite_chest_closed", "game_sprite_chest_open", "game_sprite_switch",
+		"game_sprite_door_lr_closed", "game_sprite_door_lr_open", "game_sprite_door_tb_closed", "game_sprite_door_tb_open"
+	},
+	{
+		NULL,
+		"game_ship_4s", "game_ship_3s_trb", "game_ship_3s_trl", "game_ship_3s_tlb",
+		"game_ship_3s_rbl", "game_ship_2s_tr", "game_ship_2s_tb", "game_ship_2s_tl",
+		"game_ship_2s_rb", "game_ship_2s_rl", "game_ship_2s_bl", "game_ship_1s_t",
+		"game_ship_1s_r", "game_ship_1s_b", "game_ship_1s_l", "game_ship_0s",
+		"game_sprite_key", "game_sprite_chest_closed", "game_sprite_chest_open", "game_sprite_switch",
+		"game_sprite_door_lr_closed", "game_sprite_door_lr_open", "game_sprite_door_tb_closed", "game_sprite_door_tb_open"
+	}
+};
+// interned once, so changing a tile is a table lookup
+static IGResourceId gameTileIds[GAME_TILE_STAGES][GAME_TILE_TYPES];
+static bool gameTileIdsReady = false;
+
+// board
+GameBoardRenderer::GameBoardRenderer(int _numKeys, int _z, int _tag) {
+	Quad empty = { -1, 0, 0, 0, 0, 0, 0, 0, 0, false, IGResourceNone, NULL };
+	for(int i=0; i<GAME_BOARD_WIDTH*GAME_BOARD_HEIGHT; i++)
+		tiles[i] = empty;
+	keys.assign(_numKeys, empty);
+#ifndef __S3E__
+	tileBatch = Iw2DCreateQuadBatch(GAME_BOARD_WIDTH*GAME_BOARD_HEIGHT);
+	keyBatch = Iw2DCreateQuadBatch(_numKeys);
+#endif
 	z = _z;
 	tag = _tag;
-	this->setOpacity(255);
 }
-void GameTile::changeType(int _tileType) {
-	tileType = _tileType;
-	changeImage(getResourceName(tileType).c_str());
+
+GameBoardRenderer::~GameBoardRenderer() {
+	for(int i=0; i<GAME_BOARD_WIDTH*GAME_BOARD_HEIGHT; i++)
+		if(tiles[i].image != NULL)
+			IGResourceManager::getInstance()->freeImage(tiles[i].id);
+	for(unsigned int i=0; i<keys.size(); i++)
+		if(keys[i].image != NULL)
+			IGResourceManager::getInstance()->freeImage(keys[i].id);
+#ifndef __S3E__
+	Iw2DDestroyQuadBatch(tileBatch);
+	Iw2DDestroyQuadBatch(keyBatch);
+#endif
 }
-void GameTile::changePosition(int _x, int _y) {
-	x = _x;
-	y = _y;
-	this->set(IGPoint((float)(35+50*x),(float)(95+50*y)), IGRect(image->GetWidth(), image->GetHeight()));
+
+const char* GameBoardRenderer::className() {
+	return "GameBoardRenderer";
 }
-std::string GameTile::getResourceName(int _tileType) {
-	std::string name;
-	char buffer1[50];
-	char buffer2[200];
-	switch(GameData::getInstance()->stage) {
-		case GameStageForest: sprintf(buffer1, "forest"); break;
-		case GameStageCaves: sprintf(buffer1, "caves"); break;
-		case GameStageBeach: sprintf(buffer1, "beach"); break;
-		case GameStageShip: sprintf(buffer1, "ship"); break;
+
+void GameBoardRenderer::setTile(int x, int y, int tileType) {
+	int i = GAME_BOARD_WIDTH*y+x;
+	if(place(tiles[i], tileType, x, y)) {
+#ifndef __S3E__
+		setQuad(tileBatch, i, tiles[i], 1.0f);
+#endif
 	}
-	switch(_tileType) {
-		case GameTileSolid4Sides:
-			sprintf(buffer2, "game_%s_4s", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid3SidesTRB:
-			sprintf(buffer2, "game_%s_3s_trb", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid3SidesTRL:
-			sprintf(buffer2, "game_%s_3s_trl", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid3SidesTLB:
-			sprintf(buffer2, "game_%s_3s_tlb", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid3SidesRBL:
-			sprintf(buffer2, "game_%s_3s_rbl", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid2SidesTR:
-			sprintf(buffer2, "game_%s_2s_tr", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid2SidesTB:
-			sprintf(buffer2, "game_%s_2s_tb", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid2SidesTL:
-			sprintf(buffer2, "game_%s_2s_tl", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid2SidesRB:
-			sprintf(buffer2, "game_%s_2s_rb", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid2SidesRL:
-			sprintf(buffer2, "game_%s_2s_rl", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid2SidesBL:
-			sprintf(buffer2, "game_%s_2s_bl", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid1SidesT:
-			sprintf(buffer2, "game_%s_1s_t", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid1SidesR:
-			sprintf(buffer2, "game_%s_1s_r", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid1SidesB:
-			sprintf(buffer2, "game_%s_1s_b", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid1SidesL:
-			sprintf(buffer2, "game_%s_1s_l", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileSolid0Sides:
-			sprintf(buffer2, "game_%s_0s", buffer1);
-			name = std::string(buffer2);
-			break;
-		case GameTileKey:
-			name = std::string("game_sprite_key");
-			break;
-		case GameTileChest:
-			name = std::string("game_sprite_chest_closed");
-			break;
-		case GameTileChestOpen:
-			name = std::string("game_sprite_chest_open");
-			break;
-		case GameTileSwitch:
-			name = std::string("game_sprite_switch");
-			break;
-		case GameTileDoorLRClosed:
-			name = std::string("game_sprite_door_lr_closed");
-			break;
-		case GameTileDoorLROpen:
-			name = std::string("game_sprite_door_lr_open");
-			break;
-		case GameTileDoorTBClosed:
-			name = std::string("game_sprite_door_tb_closed");
-			break;
-		case GameTileDoorTBOpen:
-			name = std::string("game_sprite_door_tb_open");
-			break;	
+}
+
+void GameBoardRenderer::setKey(int i, int x, int y, bool used) {
+	Quad& key = keys[i];
+	int tileType = used ? GameTileSpace : GameTileKey;
+
+	// a key still showing slides to its new cell, anything else snaps
+	bool slide = key.image != NULL && key.tileType == tileType;
+	float fromX = key.fx, fromY = key.fy;
+	if(!place(key, tileType, x, y))
+		return;
+	if(slide) {
+		int cells = ABS(x-(int)fromX) > ABS(y-(int)fromY) ? ABS(x-(int)fromX) : ABS(y-(int)fromY);
+		int32 duration = GAME_KEY_SLIDE_MS*(cells > 0 ? cells : 1);
+		// place() moved it to the end, a frame drawn before the next tick
+		// has to show it where the slide starts
+		key.px = fromX;
+		key.py = fromY;
+		IGTweens::getInstance()->add(this, IGTweenUser+2*i, fromX, (float)x, duration);
+		IGTweens::getInstance()->add(this, IGTweenUser+2*i+1, fromY, (float)y, duration);
+	} else {
+		IGTweens::getInstance()->cancel(this, IGTweenUser+2*i);
+		IGTweens::getInstance()->cancel(this, IGTweenUser+2*i+1);
+#ifndef __S3E__
+		setQuad(keyBatch, i, key, 1.0f);
+#endif
 	}
-	return name;
+}
+
+// key slides, two properties per key
+void GameBoardRenderer::tween(int property, float value) {
+	int i = (property-IGTweenUser)/2;
+	if(property < IGTweenUser || i >= (int)keys.size())
+		return;
+	float& f = (property-IGTweenUser)%2 == 0 ? keys[i].fx : keys[i].fy;
+	if(f != value)
+		IGDirector::getInstance()->invalidate();
+	f = value;
+}
+
+void GameBoardRenderer::snapshot() {
+	for(unsigned int i=0; i<keys.size(); i++) {
+		keys[i].px = keys[i].fx;
+		keys[i].py = keys[i].fy;
+	}
+}
+
+// true if the quad has to be redrawn, snaps it to the cell
+bool GameBoardRenderer::place(Quad& quad, int tileType, int x, int y) {
+	if(quad.tileType == tileType && quad.x == x && quad.y == y)
+		return false;
+	if(quad.tileType != tileType) {
+		if(quad.image != NULL)
+			IGResourceManager::getInstance()->freeImage(quad.id);
+		quad.tileType = tileType;
+		quad.id = getResourceId(tileType);
+		quad.image = quad.id == IGResourceNone ? NULL : IGResourceManager::getInstance()->getImage(quad.id);
+	}
+	quad.x = x;
+	quad.y = y;
+	quad.fx = quad.px = (float)x;
+	quad.fy = quad.py = (float)y;
+	quad.drawn = false;
+	IGDirector::getInstance()->invalidate();
+	return true;
+}
+
+// where the quad shows between the last two updates
+CIwSVec2 GameBoardRenderer::topLeft(Quad& quad, float t) {
+	float x = quad.px + (quad.fx-quad.px)*t, y = quad.py + (quad.fy-quad.py)*t;
+	float width = quad.image->GetWidth(), height = quad.image->GetHeight();
+	return CIwSVec2((int)((35+50*x-width/2)+IGDistorter::getInstance()->offsetX),
+		(int)((95+50*y-height/2)+IGDistorter::getInstance()->offsetY));
+}
+
+CIwSVec2 GameBoardRenderer::size(Quad& quad) {
+	return CIwSVec2((int)quad.image->GetWidth(), (int)quad.image->GetHeight());
+}
+
+#ifndef __S3E__
+// only rewrites the batch when the quad moved on screen or was placed again
+void GameBoardRenderer::setQuad(CIw2DQuadBatch* batch, int i, Quad& quad, float t) {
+	if(quad.image == NULL) {
+		Iw2DSetQuad(batch, i, NULL, CIwSVec2(0,0), CIwSVec2(0,0));
+		quad.drawn = false;
+		return;
+	}
+	CIwSVec2 position = topLeft(quad, t);
+	if(quad.drawn && position.x == quad.drawnX && position.y == quad.drawnY)
+		return;
+	Iw2DSetQuad(batch, i, quad.image, position, size(quad));
+	quad.drawnX = position.x;
+	quad.drawnY = position.y;
+	quad.drawn = true;
+}
+#endif
+
+void GameBoardRenderer::display() {
+	float t = IGDirector::getInstance()->interpolation;
+#ifdef __S3E__
+	for(int i=0; i<GAME_BOARD_WIDTH*GAME_BOARD_HEIGHT; i++)
+		if(tiles[i].image != NULL)
+			Iw2DDrawImage(tiles[i].image, topLeft(tiles[i], t), size(tiles[i]));
+	for(unsigned int i=0; i<keys.size(); i++)
+		if(keys[i].image != NULL)
+			Iw2DDrawImage(keys[i].image, topLeft(keys[i], t), size(keys[i]));
+#else
+	// sliding keys follow the interpolation, resting ones are left alone
+	for(unsigned int i=0; i<keys.size(); i++)
+		if(keys[i].image != NULL)
+			setQuad(keyBatch, i, keys[i], t);
+	// keys go over the tiles
+	Iw2DDrawQuadBatch(tileBatch);
+	Iw2DDrawQuadBatch(keyBatch);
+#endif
+}
+
+IGResourceId GameBoardRenderer::getResourceId(int _tileType) {
+	if(!gameTileIdsReady) {
+		for(int stage=0; stage<GAME_TILE_STAGES; stage++)
+			for(int type=0; type<GAME_TILE_TYPES; type++)
+				gameTileIds[stage][type] = gameTileResources[stage][type] == NULL ? IGResourceNone :
+					IGResourceManager::getInstance()->getId(gameTileResources[stage][type]);
+		gameTileIdsReady = true;
+	}
+	return gameTileIds[GameData::getInstance()->stage][_tileType];
 }
 
 // scene game
@@ -162,12 +253,18 @@ SceneGame::SceneGame() : IGScene()
 	GameData::getInstance()->activeGame = true;
 
 	// load the resources
-	IwGetResManager()->LoadGroup("game.group");
+	loadGroup("game.group");
+	// decode the in-game menu in the background while this scene is shown
+	IGResourceManager::getInstance()->preloadGroup("game_menu.group");
 
 	// start up the level
 	this->restartLevel();
 }
 
+const char* SceneGame::className() {
+	return "SceneGame";
+}
+
 SceneGame::~SceneGame() {
 	// the game is no longer active
 	GameData::getInstance()->activeGame = false;
@@ -223,32 +320,17 @@ void SceneGame::restartLevel() {
 	labelMoves->setColor(255,255,255,255);
 	this->addChild(labelMoves);
 	
-	// draw the tiles
-	int x,y;
-	GameTile* tile = NULL;
-	for(x=0; x<GAME_BOARD_WIDTH; x++) {
-		for(y=0; y<GAME_BOARD_HEIGHT; y++) {
-			if(GameData::getInstance()->tiles[x][y] != GameTileSpace) {
-				tile = new GameTile(GameData::getInstance()->tiles[x][y], x, y, 1, GameTagTiles+(GAME_BOARD_WIDTH*y+x));
-				this->addChild(tile);
-			}
-		}
-	}
-
-	// draw the keys
-	for(unsigned int i=0; i < GameData::getInstance()->keys.size(); i++) {
-		if(GameData::getInstance()->keys[i].used == false) {
-			x = GameData::getInstance()->keys[i].x;
-			y = GameData::getInstance()->keys[i].y;
-			tile = new GameTile(GameTileKey, x, y, 2, GameTagKeys+i);
-			this->addChild(tile);
-		}
-	}
+	// draw the tiles and the keys
+	GameBoardRenderer* board = new GameBoardRenderer(GameData::getInstance()->keys.size(), 1, GameTagBoard);
+	for(int x=0; x<GAME_BOARD_WIDTH; x++)
+		for(int y=0; y<GAME_BOARD_HEIGHT; y++)
+			board->setTile(x, y, GameData::getInstance()->tiles[x][y]);
+	for(unsigned int i=0; i < GameData::getInstance()->keys.size(); i++)
+		board->setKey(i, GameData::getInstance()->keys[i].x, GameData::getInstance()->keys[i].y, GameData::getInstance()->keys[i].used);
+	this->addChild(board);
 
 	// checking for winning
 	won = false;
-	wonTicks = 0;
-	wonStart = 0;
 
 	// message
 	if(GameData::getInstance()->level == 1)
@@ -273,8 +355,6 @@ void SceneGame::restartLevel() {
 
 	// achievement and leadersboard
 	isAchievementActive = isLeadersboardActive = false;
-	achievementCount = leadersboardCount = 0;
-	achievementStage = leadersboardStage = 0;
 }
 
 void SceneGame::moveKeys(int dir) {
@@ -316,30 +396,14 @@ void SceneGame::moveKeys(int dir) {
 		labelMoves->setString(buffer);
 	}
 
-	// update the tiles, keys
-	for(int x2=0; x2<GAME_BOARD_WIDTH; x2++) {
-		for(int y2=0; y2<GAME_BOARD_HEIGHT; y2++) {
-			GameTile* tile = (GameTile*)getChildByTag(GameTagTiles+(GAME_BOARD_WIDTH*y2+x2));
-			if(tile != NULL) {
-				if(GameData::getInstance()->tiles[x2][y2] != tile->tileType) {
-					tile->changeType(GameData::getInstance()->tiles[x2][y2]);
-				}
-			}
-		}
-	}
-	// update the keys
-	for(unsigned int i=0; i<GameData::getInstance()->keys.size(); i++) {
-		GameTile* tile = (GameTile*)getChildByTag(GameTagKeys+i);
-		if(tile != NULL) {
-			// if it's used now, remove it
-			if(GameData::getInstance()->keys[i].used == true) {
-				removeChildByTag(GameTagKeys+i);
-			} else {
-				// if the key has moved, update it
-				if(tile->x != GameData::getInstance()->keys[i].x || tile->y != GameData::getInstance()->keys[i].y)
-					tile->changePosition(GameData::getInstance()->keys[i].x, GameData::getInstance()->keys[i].y);
-			}
-		}
+	// update the tiles and keys, the board only touches what changed
+	GameBoardRenderer* board = (GameBoardRenderer*)getChildByTag(GameTagBoard);
+	if(board != NULL) {
+		for(int x2=0; x2<GAME_BOARD_WIDTH; x2++)
+			for(int y2=0; y2<GAME_BOARD_HEIGHT; y2++)
+				board->setTile(x2, y2, GameData::getInstance()->tiles[x2][y2]);
+		for(unsigned int i=0; i<GameData::getInstance()->keys.size(); i++)
+			board->setKey(i, GameData::getInstance()->keys[i].x, GameData::getInstance()->keys[i].y, GameData::getInstance()->keys[i].used);
 	}
 	
 	// check for a win
@@ -385,9 +449,9 @@ void SceneGame::moveKeys(int dir) {
 		this->addChild(spriteLevelCompleteLabel);
 		if(moves <= 0) {
 			// if perfect, move the "perfect!" label, and add a star
-			spriteLevelCompleteLabel->position.y -= 30;
+			spriteLevelCompleteLabel->set(IGPoint(160,280), spriteLevelCompleteLabel->size);
 			IGSprite* spritePerfect = new IGSprite("game_message_perfect", IGPoint(160, 340), 21, GameTagLevelCompletePerfect);
-			spriteLevelComplete->setOpacity(0);
+			IGTweens::getInstance()->add(spritePerfect, IGTweenOpacity, 0, 255, 330, 0, IGEaseLinear);
 			this->addChild(spritePerfect);
 			
 			// update level to be perfect
@@ -407,7 +471,10 @@ void SceneGame::moveKeys(int dir) {
 				unlockAchievement(AchievementMastermind);
 			}
 		}
-		wonStart = s3eTimerGetMs();
+		// fade it all in
+		IGTweens::getInstance()->add(spriteLevelCompleteBackground, IGTweenOpacity, 0, 128, 330, 0, IGEaseLinear);
+		IGTweens::getInstance()->add(spriteLevelComplete, IGTweenOpacity, 0, 255, 330, 0, IGEaseLinear);
+		IGTweens::getInstance()->add(spriteLevelCompleteLabel, IGTweenOpacity, 0, 255, 330, 0, IGEaseLinear);
 		won = true;
 		GameData::getInstance()->beatLevel();
 		
@@ -592,9 +659,10 @@ void SceneGame::messageDisplay(int messageToDisplay) {
 		this->addChild(spriteMessage);
 		break;
 	}
-	messageStart = s3eTimerGetMs();
-	messageCount = 0;
-	messageStage = 0;
+
+	// shown for 4 seconds, then faded out
+	if(message != GameMessageNoMessage)
+		IGTweens::getInstance()->add(spriteMessage, IGTweenOpacity, 255, 0, 100, 4000, IGEaseLinear);
 }
 
 void SceneGame::saveGame() {
@@ -611,99 +679,33 @@ void SceneGame::deleteSavedGame() {
 void SceneGame::update() {
 	// update the other nodes
 	IGNode::update();
-	
-	// message
+
+	// shaking is polled, the fades and slides run on IGTweens
+	if(Settings::getInstance()->shakeToRestart)
+		IGDirector::getInstance()->keepAwake();
+
+	// message, gone once faded out
 	if(message != GameMessageNoMessage) {
-		switch(messageStage) {
-			case 0: // wait
-				if(s3eTimerGetMs() - messageStart >= 4000) { // 4 second
-					messageStage = 1;
-					messageStart = s3eTimerGetMs();
-					messageCount = 0;
-				}
-				break;
-			case 1: // fade
-				if(s3eTimerGetMs() - messageStart >= 10) { // .01 seconds
-					messageStart = s3eTimerGetMs();
-					messageCount++;
-					IGSprite* spriteMessage = (IGSprite*)getChildByTag(GameTagMessage);
-					if(spriteMessage != NULL)
-						spriteMessage->setOpacity((uint8)((10-messageCount)*(float)(255.0/10.0)));
-					else
-						message = GameMessageNoMessage;
-				}
-				if(messageCount >= 10)
-					messageDisplay(GameMessageNoMessage);
-				break;
-		}
+		IGNode* spriteMessage = getChildByTag(GameTagMessage);
+		if(spriteMessage == NULL || !IGTweens::getInstance()->isActive(spriteMessage))
+			messageDisplay(GameMessageNoMessage);
 	}
 
-	// achievement
+	// achievement and leadersboard, gone once back down
 	if(isAchievementActive) {
-		switch(achievementStage) {
-			case 0: // moving up
-				if(s3eTimerGetMs() - achievementStart >= 3) { // .003 seconds
-					achievementStart = s3eTimerGetMs();
-					IGSprite* spriteAchievement = (IGSprite*)this->getChildByTag(GameTagAchievementBackground);
-					IGLabel* labelName = (IGLabel*)this->getChildByTag(GameTagAchievementTitle);
-					IGLabel* labelDescription = (IGLabel*)this->getChildByTag(GameTagAchievementDescription);
-					if(spriteAchievement != NULL) {
-						spriteAchievement->position.y -= 10;
-						labelName->position.y -= 10;
-						labelDescription->position.y -= 10;
-					}
-					achievementCount++;
-					if(achievementCount == 23)
-						achievementStage = 1;
-				}
-				break;
-			case 1: // waiting
-				if(s3eTimerGetMs() - achievementStart >= 3000) { // 3 seconds
-					achievementStart = s3eTimerGetMs();
-					achievementStage = 2;
-					achievementCount = 0;
-				}
-				break;
-			case 2: // moving down
-				if(s3eTimerGetMs() - achievementStart >= 3) { // .003 seconds
-					achievementStart = s3eTimerGetMs();
-					IGSprite* spriteAchievement = (IGSprite*)this->getChildByTag(GameTagAchievementBackground);
-					IGLabel* labelName = (IGLabel*)this->getChildByTag(GameTagAchievementTitle);
-					IGLabel* labelDescription = (IGLabel*)this->getChildByTag(GameTagAchievementDescription);
-					if(spriteAchievement != NULL) {
-						spriteAchievement->position.y += 10;
-						labelName->position.y += 10;
-						labelDescription->position.y += 10;
-					}
-					achievementCount++;
-					if(achievementCount == 23) {
-						removeAchievement();
-						isAchievementActive = false;
-					}
-				}
-				break;
+		IGNode* spriteAchievement = getChildByTag(GameTagAchievementBackground);
+		if(spriteAchievement == NULL || !IGTweens::getInstance()->isActive(spriteAchievement)) {
+			removeAchievement();
+			isAchievementActive = false;
 		}
 	}
-
-	// if the level has been won
-	if(won) {
-		if(wonTicks < 10) {
-			if(s3eTimerGetMs() - wonStart >= 10) { //.01 seconds
-				wonStart = s3eTimerGetMs();
-				wonTicks++;
-				IGSprite* spriteLevelCompleteBackground = (IGSprite*)getChildByTag(GameTagLevelCompleteBackground);
-				if(spriteLevelCompleteBackground != NULL)
-					spriteLevelCompleteBackground->setOpacity((uint8)(wonTicks*(float)(128.0/10.0)));
-				IGSprite* spriteLevelComplete = (IGSprite*)getChildByTag(GameTagLevelComplete);
-				if(spriteLevelComplete != NULL)
-					spriteLevelComplete->setOpacity((uint8)(wonTicks*(float)(255.0/10.0)));
-				IGLabel* spriteLevelCompleteLabel = (IGLabel*)getChildByTag(GameTagLevelCompleteLabel);
-				if(spriteLevelCompleteLabel != NULL)
-					spriteLevelCompleteLabel->setOpacity((uint8)(wonTicks*(float)(255.0/10.0)));
-				IGSprite* spriteLevelCompletePerfect = (IGSprite*)getChildByTag(GameTagLevelCompletePerfect);
-				if(spriteLevelCompletePerfect != NULL)
-					spriteLevelCompletePerfect->setOpacity((uint8)(wonTicks*(float)(255.0/10.0)));
-			}
+	if(isLeadersboardActive) {
+		IGNode* spriteLeadersboard = getChildByTag(GameTagLeadersboardAnim);
+		if(spriteLeadersboard == NULL || !IGTweens::getInstance()->isActive(spriteLeadersboard)) {
+			this->removeChildByTag(GameTagLeadersboardAnim);
+			this->removeChildByTag(GameTagLeadersboardTitle);
+			this->removeChildByTag(GameTagLeadersboardDescription);
+			isLeadersboardActive = false;
 		}
 	}
 	
@@ -881,10 +883,10 @@ void SceneGame::animateAchievement(int achievementId) {
 	this->addChild(labelDescription);
 
 	// start the achievement
-	achievementCount = 0;
+	slideBanner(spriteAchievement);
+	slideBanner(labelName);
+	slideBanner(labelDescription);
 	isAchievementActive = true;
-	achievementStage = 0;
-	achievementStart = s3eTimerGetMs();
 }
 
 void SceneGame::animateLeadersboard(bool win_or_top10) {
@@ -907,10 +909,17 @@ void SceneGame::animateLeadersboard(bool win_or_top10) {
 	this->addChild(labelDescription);
 
 	// start the leadersboard
-	leadersboardCount = 0;
+	slideBanner(spriteLeadersboard);
+	slideBanner(labelName);
+	slideBanner(labelDescription);
 	isLeadersboardActive = true;
-	leadersboardStage = 0;
-	leadersboardStart = s3eTimerGetMs();
+}
+
+// up by 230, stay for 3 seconds and back down
+void SceneGame::slideBanner(IGSprite* sprite) {
+	float y = sprite->position.y;
+	IGTweens::getInstance()->add(sprite, IGTweenY, y, y-230, 760);
+	IGTweens::getInstance()->then(sprite, IGTweenY, y, 760, 3000, IGEaseIn);
 }
 
 void SceneGame::removeAchievement() {
@@ -4,6 +4,7 @@
 
 #include "Iw2D.h"
 #include "ig2d/ig.h"
+#include "game_data.h"
 
 // menu button
 class GameButtonMenu: public IGButton {
@@ -13,17 +14,44 @@ public:
 	void buttonReleased();
 };
 
-// tile class
-class GameTile: public IGSprite {
+// the board tiles and keys, kept in quad batches so the whole board
+// draws with one call per image and a move only rewrites what changed
+class GameBoardRenderer: public IGNode {
 public:
-	GameTile(int _tileType, int _x, int _y, int _z, int _tag);
-	void changeType(int _tileType);
-	void changePosition(int _x, int _y);
-	int x, y;
-	int tileType;
+	GameBoardRenderer(int _numKeys, int _z, int _tag);
+	~GameBoardRenderer();
+	const char* className();
+	void display();
+	void snapshot();
+	void tween(int property, float value);
+
+	// GameTileSpace and used keys show nothing, keys moved on the board slide
+	void setTile(int x, int y, int tileType);
+	void setKey(int i, int x, int y, bool used);
 
 private:
-	std::string getResourceName(int _tileType);
+	struct Quad {
+		int tileType;
+		int x, y;
+		float fx, fy; // cell shown, between cells while sliding
+		float px, py; // cell shown at the last update
+		int drawnX, drawnY; // last written to the batch
+		bool drawn;
+		IGResourceId id;
+		CIw2DImage* image;
+	};
+	Quad tiles[GAME_BOARD_WIDTH*GAME_BOARD_HEIGHT];
+	std::vector<Quad> keys;
+	bool place(Quad& quad, int tileType, int x, int y);
+	CIwSVec2 topLeft(Quad& quad, float t);
+	CIwSVec2 size(Quad& quad);
+#ifndef __S3E__
+	CIw2DQuadBatch* tileBatch;
+	CIw2DQuadBatch* keyBatch;
+	void setQuad(CIw2DQuadBatch* batch, int i, Quad& quad, float t);
+#endif
+
+	static IGResourceId getResourceId(int _tileType);
 };
 
 // tags
@@ -40,8 +68,7 @@ typedef enum {
 	GameTagLeadersboardTitle = 10,
 	GameTagLeadersboardDescription = 11,
 	GameTagMessage = 12,
-	GameTagTiles = 100,
-	GameTagKeys = 200
+	GameTagBoard = 13
 } GameTags;
 
 // messages
@@ -56,6 +83,7 @@ typedef enum {
 class SceneGame: public IGScene {
 public:
 	SceneGame();
+	const char* className();
 	~SceneGame();
 	void restartLevel();
 	void moveKeys(int dir);
@@ -63,24 +91,16 @@ public:
 	// messages
 	void messageDisplay(int messageToDisplay);
 	int message;
-	int64 messageStart;
-	int messageCount;
-	int messageStage;
 
 	// achievements and leadersboard
 	void unlockAchievement(int achievementId);
 	void animateAchievement(int achievementId);
 	void removeAchievement();
 	bool isAchievementActive;
-	int achievementCount;
-	int achievementStage;
-	int64 achievementStart;
 	void checkForLeadersboard();
 	void animateLeadersboard(bool win_or_top10);
-	int leadersboardCount;
-	int leadersboardStage;
-	int64 leadersboardStart;
 	bool isLeadersboardActive;
+	void slideBanner(IGSprite* sprite);
 
 	// misc methods
 	void perfectLevel(); // set current level to perfect
@@ -88,8 +108,6 @@ public:
 
 	// beating the level variables
 	bool won;
-	int wonTicks;
-	int64 wonStart;
 
 	// saving the game
 	bool firstMove;
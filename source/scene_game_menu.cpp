@@ -9,10 +9,10 @@
 
 // resume button
 GameMenuButtonResume::GameMenuButtonResume() {
-	imageNormalName = std::string("game_menu_resume");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu_resume2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu_resume");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu_resume2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,196));
 	touchSize = IGRect(320,50);
@@ -30,10 +30,10 @@ void GameMenuButtonResume::buttonReleased() {
 
 // restart button
 GameMenuButtonRestart::GameMenuButtonRestart() {
-	imageNormalName = std::string("game_menu_restart");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu_restart2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu_restart");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu_restart2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,246));
 	touchSize = IGRect(320,50);
@@ -53,10 +53,10 @@ void GameMenuButtonRestart::buttonReleased() {
 
 // next button
 GameMenuButtonNext::GameMenuButtonNext() {
-	imageNormalName = std::string("game_menu_next");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu_next2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu_next");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu_next2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,296));
 	touchSize = IGRect(320,50);
@@ -100,10 +100,10 @@ void GameMenuButtonNext::buttonReleased() {
 
 // options button
 GameMenuButtonOptions::GameMenuButtonOptions() {
-	imageNormalName = std::string("game_menu_options");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu_options2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu_options");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu_options2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,376));
 	touchSize = IGRect(320,50);
@@ -122,10 +122,10 @@ void GameMenuButtonOptions::buttonReleased() {
 
 // abandon button
 GameMenuButtonAbandon::GameMenuButtonAbandon() {
-	imageNormalName = std::string("game_menu_abandon");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu_abandon2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu_abandon");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu_abandon2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,426));
 	touchSize = IGRect(320,50);
@@ -150,10 +150,10 @@ void GameMenuButtonAbandon::buttonReleased() {
 
 // error continue button
 GameMenuButtonErrorContinue::GameMenuButtonErrorContinue() {
-	imageNormalName = std::string("game_menu_error_continue");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("game_menu_error_continue2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("game_menu_error_continue");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("game_menu_error_continue2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,332));
 	touchSize = IGRect(320,50);
@@ -174,7 +174,7 @@ SceneGameMenu::SceneGameMenu() : IGScene()
 	errorUp = false;
 
 	// load the resources
-	IwGetResManager()->LoadGroup("game_menu.group");
+	loadGroup("game_menu.group");
 
 	// the background
 	IGSprite* spriteBackground = new IGSprite("background_forest_light", IGPoint(160,240), 0);
@@ -213,6 +213,10 @@ SceneGameMenu::SceneGameMenu() : IGScene()
 	this->addChild(labelInfo);
 }
 
+const char* SceneGameMenu::className() {
+	return "SceneGameMenu";
+}
+
 SceneGameMenu::~SceneGameMenu() {
 }
 
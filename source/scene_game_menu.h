@@ -56,6 +56,7 @@ typedef enum {
 class SceneGameMenu: public IGScene {
 public:
 	SceneGameMenu();
+	const char* className();
 	~SceneGameMenu();
 
 	// error messages
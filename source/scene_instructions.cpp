@@ -6,10 +6,10 @@
 
 // menu button
 InstructionsButtonMenu::InstructionsButtonMenu() {
-	imageNormalName = std::string("instructions_menu");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("instructions_menu2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("instructions_menu");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("instructions_menu2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,452));
 	touchSize = IGRect(98,56);
@@ -26,10 +26,10 @@ void InstructionsButtonMenu::buttonReleased() {
 
 // back button
 InstructionsButtonBack::InstructionsButtonBack() {
-	imageNormalName = std::string("instructions_back");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("instructions_back2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("instructions_back");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("instructions_back2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(55,452));
 	touchSize = IGRect(111,56);
@@ -45,10 +45,10 @@ void InstructionsButtonBack::buttonReleased() {
 
 // next button
 InstructionsButtonNext::InstructionsButtonNext() {
-	imageNormalName = std::string("instructions_next");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("instructions_next2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("instructions_next");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("instructions_next2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(265,452));
 	touchSize = IGRect(111,56);
@@ -68,7 +68,7 @@ SceneInstructions::SceneInstructions() : IGScene()
 	IGLog("SceneInstructions init");
 
 	// load the resources
-	IwGetResManager()->LoadGroup("instructions.group");
+	loadGroup("instructions.group");
 	
 	// the background
 	IGSprite* spriteBackground = new IGSprite("background_forest_dark", IGPoint(160,240), 0);
@@ -93,6 +93,10 @@ SceneInstructions::SceneInstructions() : IGScene()
 	this->addChild(spritePage);
 }
 
+const char* SceneInstructions::className() {
+	return "SceneInstructions";
+}
+
 SceneInstructions::~SceneInstructions() {
 }
 
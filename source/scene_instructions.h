@@ -29,6 +29,7 @@ public:
 class SceneInstructions: public IGScene {
 public:
 	SceneInstructions();
+	const char* className();
 	~SceneInstructions();
 
 	InstructionsButtonBack* buttonBack;
@@ -7,10 +7,10 @@
 
 // menu button
 LeadersboardButtonMenu::LeadersboardButtonMenu() {
-	imageNormalName = std::string("leadersboard_menu");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("leadersboard_menu2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("leadersboard_menu");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("leadersboard_menu2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,452));
 	touchSize = IGRect(98,56);
@@ -27,10 +27,10 @@ void LeadersboardButtonMenu::buttonReleased() {
 
 // back button
 LeadersboardButtonBack::LeadersboardButtonBack() {
-	imageNormalName = std::string("achievements_back");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("achievements_back2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("achievements_back");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("achievements_back2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(55,452));
 	touchSize = IGRect(111,56);
@@ -46,10 +46,10 @@ void LeadersboardButtonBack::buttonReleased() {
 
 // next button
 LeadersboardButtonNext::LeadersboardButtonNext() {
-	imageNormalName = std::string("leadersboard_next");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("leadersboard_next2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("leadersboard_next");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("leadersboard_next2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(265,452));
 	touchSize = IGRect(111,56);
@@ -69,7 +69,7 @@ SceneLeadersboard::SceneLeadersboard() : IGScene()
 	IGLog("SceneLeadersboard init");
 	
 	// load the resources
-	IwGetResManager()->LoadGroup("leadersboard.group");
+	loadGroup("leadersboard.group");
 	
 	// the background
 	IGSprite* spriteBackground = new IGSprite("background_wood", IGPoint(160,240), 0);
@@ -98,6 +98,10 @@ SceneLeadersboard::SceneLeadersboard() : IGScene()
 	updateLeadersboard();
 }
 
+const char* SceneLeadersboard::className() {
+	return "SceneLeadersboard";
+}
+
 SceneLeadersboard::~SceneLeadersboard() {
 }
 
@@ -34,6 +34,7 @@ typedef enum {
 class SceneLeadersboard: public IGScene {
 public:
 	SceneLeadersboard();
+	const char* className();
 	~SceneLeadersboard();
 
 	LeadersboardButtonBack* buttonBack;
@@ -9,14 +9,14 @@
 
 // key
 MapKey::MapKey(float x, float y) {
-	addFrame(std::string("map_key1"));
-	addFrame(std::string("map_key2"));
-	addFrame(std::string("map_key3"));
-	addFrame(std::string("map_key4"));
-	addFrame(std::string("map_key5"));
-	addFrame(std::string("map_key4"));
-	addFrame(std::string("map_key3"));
-	addFrame(std::string("map_key2"));
+	addFrame("map_key1");
+	addFrame("map_key2");
+	addFrame("map_key3");
+	addFrame("map_key4");
+	addFrame("map_key5");
+	addFrame("map_key4");
+	addFrame("map_key3");
+	addFrame("map_key2");
 	firstFrame();
 	this->set(IGPoint(x,y));
 	this->setFPS(8);
@@ -26,14 +26,14 @@ MapKey::MapKey(float x, float y) {
 
 // lock
 MapLock::MapLock(float x, float y) {
-	addFrame(std::string("map_lock1"));
-	addFrame(std::string("map_lock2"));
-	addFrame(std::string("map_lock3"));
-	addFrame(std::string("map_lock4"));
-	addFrame(std::string("map_lock5"));
-	addFrame(std::string("map_lock4"));
-	addFrame(std::string("map_lock3"));
-	addFrame(std::string("map_lock2"));
+	addFrame("map_lock1");
+	addFrame("map_lock2");
+	addFrame("map_lock3");
+	addFrame("map_lock4");
+	addFrame("map_lock5");
+	addFrame("map_lock4");
+	addFrame("map_lock3");
+	addFrame("map_lock2");
 	firstFrame();
 	this->set(IGPoint(x,y));
 	this->setFPS(8);
@@ -48,7 +48,9 @@ SceneMap::SceneMap() : IGScene()
 	float x, y;
 
 	// load the resources
-	IwGetResManager()->LoadGroup("map.group");
+	loadGroup("map.group");
+	// decode the level selection in the background while this scene is shown
+	IGResourceManager::getInstance()->preloadGroup("select_level.group");
 	
 	// the background
 	IGSprite* spriteBackgroundBlack = new IGSprite("background_black", IGPoint(160,240), 0);
@@ -98,6 +100,10 @@ SceneMap::SceneMap() : IGScene()
 	}
 }
 
+const char* SceneMap::className() {
+	return "SceneMap";
+}
+
 SceneMap::~SceneMap() {
 }
 
@@ -19,6 +19,7 @@ public:
 class SceneMap: public IGScene {
 public:
 	SceneMap();
+	const char* className();
 	~SceneMap();
 
 	bool stageLockedForest;
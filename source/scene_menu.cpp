@@ -11,10 +11,10 @@
 
 // play game button
 MenuButtonPlayGame::MenuButtonPlayGame() {
-	imageNormalName = std::string("menu_play_game");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("menu_play_game2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("menu_play_game");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("menu_play_game2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,228));
 	touchSize = IGRect(320,56);
@@ -31,10 +31,10 @@ void MenuButtonPlayGame::buttonReleased() {
 
 // instructions button
 MenuButtonInstructions::MenuButtonInstructions() {
-	imageNormalName = std::string("menu_instructions");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("menu_instructions2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("menu_instructions");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("menu_instructions2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,284));
 	touchSize = IGRect(320,56);
@@ -51,10 +51,10 @@ void MenuButtonInstructions::buttonReleased() {
 
 // achievements button
 MenuButtonAchievements::MenuButtonAchievements() {
-	imageNormalName = std::string("menu_achievements");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("menu_achievements2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("menu_achievements");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("menu_achievements2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,340));
 	touchSize = IGRect(320,56);
@@ -71,10 +71,10 @@ void MenuButtonAchievements::buttonReleased() {
 
 // leadersboard button
 MenuButtonLeadersboard::MenuButtonLeadersboard() {
-	imageNormalName = std::string("menu_leadersboard");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("menu_leadersboard2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("menu_leadersboard");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("menu_leadersboard2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,396));
 	touchSize = IGRect(320,56);
@@ -91,10 +91,10 @@ void MenuButtonLeadersboard::buttonReleased() {
 
 // options button
 MenuButtonOptions::MenuButtonOptions() {
-	imageNormalName = std::string("menu_options");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("menu_options2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("menu_options");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("menu_options2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,452));
 	touchSize = IGRect(320,56);
@@ -112,10 +112,10 @@ void MenuButtonOptions::buttonReleased() {
 
 // other games button
 MenuButtonOtherGames::MenuButtonOtherGames() {
-	imageNormalName = std::string("menu_other_games");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("menu_other_games2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("menu_other_games");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("menu_other_games2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,508));
 	touchSize = IGRect(320,56);
@@ -136,7 +136,9 @@ SceneMenu::SceneMenu() : IGScene()
 	IGLog("SceneMenu init");
 
 	// load the resources
-	IwGetResManager()->LoadGroup("menu.group");
+	loadGroup("menu.group");
+	// decode the map in the background while this scene is shown
+	IGResourceManager::getInstance()->preloadGroup("map.group");
 	
 	// the background
 	IGSprite* spriteBackground = new IGSprite("background_forest_light", IGPoint(160,240), 0);
@@ -160,5 +162,9 @@ SceneMenu::SceneMenu() : IGScene()
 	this->addChild(buttonOtherGames);
 }
 
+const char* SceneMenu::className() {
+	return "SceneMenu";
+}
+
 SceneMenu::~SceneMenu() {
 }
@@ -47,6 +47,7 @@ public:
 class SceneMenu: public IGScene {
 public:
 	SceneMenu();
+	const char* className();
 	~SceneMenu();
 };
 
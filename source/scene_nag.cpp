@@ -10,10 +10,10 @@
 
 // yes button
 NagButtonYes::NagButtonYes() {
-	imageNormalName = std::string("nag_yes");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("nag_yes2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("nag_yes");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("nag_yes2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,340));
 	touchSize = IGRect(320,56);
@@ -38,10 +38,10 @@ void NagButtonYes::buttonReleased() {
 
 // no button
 NagButtonNo::NagButtonNo() {
-	imageNormalName = std::string("nag_no");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("nag_no2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("nag_no");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("nag_no2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,396));
 	touchSize = IGRect(320,56);
@@ -61,7 +61,7 @@ SceneNag::SceneNag() : IGScene()
 	IGLog("SceneNag init");
 
 	// load the resources
-	IwGetResManager()->LoadGroup("nag.group");
+	loadGroup("nag.group");
 	
 	// the background
 	IGSprite* spriteBackground = new IGSprite("background_forest_dark", IGPoint(160,240), 0);
@@ -78,6 +78,10 @@ SceneNag::SceneNag() : IGScene()
 	this->addChild(buttonNo);
 }
 
+const char* SceneNag::className() {
+	return "SceneNag";
+}
+
 SceneNag::~SceneNag() {
 }
 
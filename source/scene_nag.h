@@ -23,6 +23,7 @@ public:
 class SceneNag: public IGScene {
 public:
 	SceneNag();
+	const char* className();
 	~SceneNag();
 	void ontoTheGame();
 };
@@ -10,14 +10,14 @@
 // back button
 OptionsButtonBack::OptionsButtonBack() {
 	if(GameData::getInstance()->optionsReturnsToGame) {
-		imageNormalName = std::string("options_back_game");
-	imageSelectedName = std::string("options_back_game2");
+		imageNormalId = IGResourceManager::getInstance()->getId("options_back_game");
+	imageSelectedId = IGResourceManager::getInstance()->getId("options_back_game2");
 	} else {
-		imageNormalName = std::string("options_back_menu");
-		imageSelectedName = std::string("options_back_menu2");
+		imageNormalId = IGResourceManager::getInstance()->getId("options_back_menu");
+		imageSelectedId = IGResourceManager::getInstance()->getId("options_back_menu2");
 	}
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,452));
 	touchSize = IGRect(320,56);
@@ -37,10 +37,10 @@ void OptionsButtonBack::buttonReleased() {
 
 // reset button
 OptionsButtonReset::OptionsButtonReset() {
-	imageNormalName = std::string("options_reset");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("options_reset2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("options_reset");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("options_reset2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(160,376));
 	touchSize = IGRect(320,56);
@@ -56,10 +56,10 @@ void OptionsButtonReset::buttonReleased() {
 
 // reset yes button
 OptionsButtonResetYes::OptionsButtonResetYes() {
-	imageNormalName = std::string("options_reset_confirm_yes");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("options_reset_confirm_yes2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("options_reset_confirm_yes");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("options_reset_confirm_yes2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(85,260));
 	touchSize = IGRect(150,56);
@@ -75,10 +75,10 @@ void OptionsButtonResetYes::buttonReleased() {
 
 // reset cancel button
 OptionsButtonResetCancel::OptionsButtonResetCancel() {
-	imageNormalName = std::string("options_reset_confirm_cancel");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("options_reset_confirm_cancel2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("options_reset_confirm_cancel");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("options_reset_confirm_cancel2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(235,260));
 	touchSize = IGRect(150,56);
@@ -98,7 +98,7 @@ SceneOptions::SceneOptions() : IGScene()
 	IGLog("SceneOptions init");
 
 	// load the resources
-	IwGetResManager()->LoadGroup("options.group");
+	loadGroup("options.group");
 	
 	// the background
 	IGSprite* spriteBackground = new IGSprite("options_background", IGPoint(160,240), 0);
@@ -133,6 +133,10 @@ SceneOptions::SceneOptions() : IGScene()
 	resetConfirmUp = false;
 }
 
+const char* SceneOptions::className() {
+	return "SceneOptions";
+}
+
 SceneOptions::~SceneOptions() {
 }
 
@@ -44,6 +44,7 @@ typedef enum {
 class SceneOptions: public IGScene {
 public:
 	SceneOptions();
+	const char* className();
 	~SceneOptions();
 	
 	// options
@@ -8,10 +8,10 @@
 
 // back button
 SelectLevelButtonBack::SelectLevelButtonBack() {
-	imageNormalName = std::string("select_level_back");
-	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalName);
-	imageSelectedName = std::string("select_level_back2");
-	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedName);
+	imageNormalId = IGResourceManager::getInstance()->getId("select_level_back");
+	imageNormal = IGResourceManager::getInstance()->getImage(imageNormalId);
+	imageSelectedId = IGResourceManager::getInstance()->getId("select_level_back2");
+	imageSelected = IGResourceManager::getInstance()->getImage(imageSelectedId);
 	image = imageNormal;
 	this->set(IGPoint(32,35));
 	touchSize = IGRect(63,70);
@@ -29,8 +29,8 @@ void SelectLevelButtonBack::buttonReleased() {
 // level number label
 SelectLevelLabelNumber::SelectLevelLabelNumber(int _level, float x, float y) {
 	level = _level;
-	fontName = std::string("font_deutsch_26");
-	font = IGResourceManager::getInstance()->getFont(fontName);
+	fontId = IGResourceManager::getInstance()->getId("font_deutsch_26");
+	font = IGResourceManager::getInstance()->getFont(fontId);
 	set(IGPoint(x, y), IGRect(126, 120));
 	char buffer[200];
 	sprintf(buffer, "%i", level);
@@ -81,7 +81,9 @@ SceneSelectLevel::SceneSelectLevel() : IGScene()
 	IGLog("SceneSelectLevel init");
 
 	// load the resources
-	IwGetResManager()->LoadGroup("select_level.group");
+	loadGroup("select_level.group");
+	// decode the game board in the background while this scene is shown
+	IGResourceManager::getInstance()->preloadGroup("game.group");
 	
 	// the background
 	IGSprite* spriteBackground = NULL;
@@ -150,6 +152,10 @@ SceneSelectLevel::SceneSelectLevel() : IGScene()
 	loadLevelTick = 0;
 }
 
+const char* SceneSelectLevel::className() {
+	return "SceneSelectLevel";
+}
+
 SceneSelectLevel::~SceneSelectLevel() {
 }
 
@@ -184,6 +190,7 @@ void SceneSelectLevel::updateDifficulty() {
 void SceneSelectLevel::update() {
 	// level selected?
 	if(levelToLoad != -1) {
+		IGDirector::getInstance()->keepAwake();
 		if(loadLevelTick == 2) {
 			// change music
 			Sounds::getInstance()->startMusicGameplay();
@@ -35,6 +35,7 @@ public:
 class SceneSelectLevel: public IGScene {
 public:
 	SceneSelectLevel();
+	const char* className();
 	~SceneSelectLevel();
 	int startingLevel;
 
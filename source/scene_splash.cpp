@@ -8,8 +8,8 @@
 
 // splash image
 SplashImage::SplashImage() {
-	imageName = std::string("splash");
-	image = IGResourceManager::getInstance()->getImage(imageName);
+	imageId = IGResourceManager::getInstance()->getId("splash");
+	image = IGResourceManager::getInstance()->getImage(imageId);
 	this->set(IGPoint(160,240));
 	z = 0;
 	tag = 0;
@@ -21,7 +21,7 @@ SceneSplash::SceneSplash() {
 	IGLog("SceneSplash init");
 
 	// load the resources
-	IwGetResManager()->LoadGroup("splash.group");
+	loadGroup("splash.group");
 
 	// if using an iphone, skip the wait and just fade out
 	if(s3eDeviceGetInt(S3E_DEVICE_OS) == S3E_OS_ID_IPHONE)
@@ -43,10 +43,15 @@ SceneSplash::SceneSplash() {
 	Settings::getInstance()->save();
 }
 
+const char* SceneSplash::className() {
+	return "SceneSplash";
+}
+
 SceneSplash::~SceneSplash() {
 }
 
 void SceneSplash::update() {
+	IGDirector::getInstance()->keepAwake();
 	switch(stage) {
 		case 0: // waiting
 			if(s3eTimerGetMs() - start >= 2000) { // 2 second
@@ -15,6 +15,7 @@ public:
 class SceneSplash: public IGScene {
 public:
 	SceneSplash();
+	const char* className();
 	~SceneSplash();
 	void update();
 	
@@ -0,0 +1,113 @@
+#include "sound_bank.h"
+#include "s3e.h"
+#include "ig2d/ig_global.h"
+#include <string.h>
+
+// IMA ADPCM step sizes and how each code moves through them
+static const int16 imaSteps[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+	12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+static const int imaIndexMoves[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+SoundBank::SoundBank() {
+	data = NULL;
+	size = 0;
+	header = NULL;
+	entries = NULL;
+}
+
+SoundBank::~SoundBank() {
+	if(data != NULL)
+		s3eFreeBase(data);
+}
+
+bool SoundBank::load(const char* filename) {
+	s3eFile* file = s3eFileOpen(filename, "rb");
+	if(file == NULL)
+		return false;
+	size = s3eFileGetSize(file);
+	data = (char*)s3eMallocBase(size);
+	bool ok = data != NULL && s3eFileRead(data, size, 1, file) == 1;
+	s3eFileClose(file);
+
+	// check everything up front, so the rest can trust the entries
+	header = (SoundBankHeader*)data;
+	entries = (SoundBankEntry*)(data + sizeof(SoundBankHeader));
+	if(ok)
+		ok = size >= sizeof(SoundBankHeader) && header->magic == SOUND_BANK_MAGIC && header->version == SOUND_BANK_VERSION &&
+			header->count <= (size - sizeof(SoundBankHeader)) / sizeof(SoundBankEntry);
+	for(uint32 i=0; ok && i<header->count; i++) {
+		SoundBankEntry& e = entries[i];
+		uint32 blocks = (e.numSamples + SOUND_BANK_BLOCK_SAMPLES - 1) / SOUND_BANK_BLOCK_SAMPLES;
+		uint32 needed = e.format == SOUND_BANK_PCM ? e.numSamples*2 : blocks*SOUND_BANK_BLOCK_SIZE;
+		ok = (e.format == SOUND_BANK_PCM || e.format == SOUND_BANK_IMA_ADPCM) && e.size >= needed &&
+			e.offset <= size && e.size <= size - e.offset;
+		e.name[SOUND_BANK_NAME_SIZE-1] = '\0';
+	}
+	if(!ok) {
+		fprintf(stderr, "Error loading sound bank: %s.\n", filename);
+		if(data != NULL)
+			s3eFreeBase(data);
+		data = NULL;
+		size = 0;
+		header = NULL;
+		entries = NULL;
+		return false;
+	}
+	if(header->rate != 44100)
+		IGLog("Sound bank isn't 44.1 kHz, it will play at the wrong pitch");
+	return true;
+}
+
+int SoundBank::find(const char* name) {
+	if(header == NULL)
+		return -1;
+	for(uint32 i=0; i<header->count; i++)
+		if(strcmp(entries[i].name, name) == 0)
+			return i;
+	return -1;
+}
+
+uint32 SoundBank::getNumSamples(int index) {
+	return entries[index].numSamples;
+}
+
+uint32 SoundBank::getSize(int index) {
+	return entries[index].size;
+}
+
+void SoundBank::decode(int index, int16* out) {
+	SoundBankEntry& e = entries[index];
+	const uint8* in = (const uint8*)data + e.offset;
+	if(e.format == SOUND_BANK_PCM) {
+		memcpy(out, in, e.numSamples*2);
+		return;
+	}
+	for(uint32 n=0; n<e.numSamples; n+=SOUND_BANK_BLOCK_SAMPLES, in+=SOUND_BANK_BLOCK_SIZE) {
+		// block header: predictor (little endian), step index, unused
+		int predictor = (int16)(in[0] | (in[1] << 8));
+		int step = in[2] > 88 ? 88 : in[2];
+		uint32 count = e.numSamples - n < SOUND_BANK_BLOCK_SAMPLES ? e.numSamples - n : SOUND_BANK_BLOCK_SAMPLES;
+		for(uint32 i=0; i<count; i++) {
+			// low nibble first
+			int code = (in[4 + i/2] >> ((i & 1) * 4)) & 15;
+			int s = imaSteps[step];
+			int diff = s >> 3;
+			if(code & 4) diff += s;
+			if(code & 2) diff += s >> 1;
+			if(code & 1) diff += s >> 2;
+			predictor += (code & 8) ? -diff : diff;
+			if(predictor > 32767) predictor = 32767;
+			else if(predictor < -32768) predictor = -32768;
+			step += imaIndexMoves[code & 7];
+			if(step < 0) step = 0;
+			else if(step > 88) step = 88;
+			out[n + i] = (int16)predictor;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#ifdef SOUND_BANK_TOOL
+// the host tool has no s3e
+#include <stdint.h>
+typedef uint32_t uint32;
+typedef int16_t int16;
+#else
+#include "s3eTypes.h"
+#endif
+
+// all the sound effects in one little endian file, written by
+// proj_compat/tools/sndpack:
+//   header, one entry per sound, then the sound data
+// samples are 16 bit mono, stored as IMA ADPCM in blocks that each start
+// from their own predictor, so 4 bits a sample
+#define SOUND_BANK_MAGIC 0x42534b53 // "SKSB"
+#define SOUND_BANK_VERSION 1
+#define SOUND_BANK_NAME_SIZE 32
+#define SOUND_BANK_PCM 0
+#define SOUND_BANK_IMA_ADPCM 1
+#define SOUND_BANK_BLOCK_SAMPLES 1024
+#define SOUND_BANK_BLOCK_SIZE (4 + SOUND_BANK_BLOCK_SAMPLES/2)
+
+struct SoundBankHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 count;
+	uint32 rate;
+};
+
+struct SoundBankEntry {
+	char name[SOUND_BANK_NAME_SIZE];
+	uint32 format;
+	uint32 numSamples;
+	uint32 offset; // from the start of the file
+	uint32 size;
+};
+
+class SoundBank {
+public:
+	SoundBank();
+	~SoundBank();
+
+	// the whole file in one read
+	bool load(const char* filename);
+
+	// index of a sound, -1 if it isn't in the bank
+	int find(const char* name);
+	uint32 getNumSamples(int index);
+	// bytes the sound takes in the bank
+	uint32 getSize(int index);
+	// bytes the bank holds in memory
+	uint32 getSize() { return size; }
+
+	// decode a whole sound into getNumSamples(index) samples
+	void decode(int index, int16* out);
+
+private:
+	char* data;
+	uint32 size;
+	SoundBankHeader* header;
+	SoundBankEntry* entries;
+};
+
+#endif // SOUND_BANK_H
@@ -1,6 +1,7 @@
 #include "config.h"
 #include "ig2d/ig_global.h"
 #include "sounds.h"
+#include "sound_bank.h"
 #include "settings.h"
 #include "game_data.h"
 #include <s3eSound.h>
@@ -8,6 +9,9 @@
 #include <s3eIOSBackgroundMusic.h>
 #include <s3eIOSBackgroundAudio.h>
 
+// music changes fade over this long
+#define MUSIC_CROSSFADE_MS 2000
+
 Sounds* Sounds::instance = NULL;
 
 Sounds* Sounds::getInstance() {
@@ -26,6 +30,7 @@ Sounds::Sounds() {
 	soundClick = NULL;
 	soundMapLocked = NULL;
 	soundUnlockAchievement = NULL;
+	bank = NULL;
 	
 	if(AIRPLAY_DEVICE == AIRPLAY_DEVICE_IPHONE) {
 		// for iphone, if there's background music playing, keep it playing
@@ -50,6 +55,7 @@ Sounds::Sounds() {
 
 	// start playing music?
 	gameplayStart = 0;
+	gameplayMusicNum = -1;
 	gameplayPlaying = false;
 	if(Settings::getInstance()->musicEnabled) {
 		if(GameData::getInstance()->isSavedGame())
@@ -69,79 +75,171 @@ void Sounds::shutdown() {
 }
 
 void Sounds::loadSounds() {
-	soundKeyMove = loadSound("key_move.raw");
-	soundOpenChest = loadSound("open_chest.raw");
-	soundRestartLevel = loadSound("restart_level.raw");
-	soundDoor = loadSound("door.raw");
-	soundClick = loadSound("click.raw");
-	soundMapLocked = loadSound("map_locked.raw");
-	soundUnlockAchievement= loadSound("unlock_achievement.raw");
+	// one read for all of them; a sound missing from the bank comes from its .raw
+	bank = new SoundBank();
+	if(bank->load("sounds.bank") == false) {
+		delete bank;
+		bank = NULL;
+	}
+
+	// when the voices run out, higher priority sounds take them from lower ones;
+	// a burst of key moves only ever holds a few. the rare ones are decoded
+	// when first played
+	soundKeyMove = loadSound("key_move.raw", 0, 4);
+	soundOpenChest = loadSound("open_chest.raw", 2, 2);
+	soundRestartLevel = loadSound("restart_level.raw", 2, 1, true);
+	soundDoor = loadSound("door.raw", 2, 2);
+	soundClick = loadSound("click.raw", 1, 2);
+	soundMapLocked = loadSound("map_locked.raw", 1, 1, true);
+	soundUnlockAchievement= loadSound("unlock_achievement.raw", 3, 1, true);
+	releaseBank();
 	IGLog("Sounds loaded");
+	reportMemory();
 }
 
 void Sounds::unloadSounds() {
-	if(soundKeyMove != NULL) {
-		s3eFreeBase(soundKeyMove->buffer);
-		delete soundKeyMove;
-		soundKeyMove = NULL;
-	}
-	if(soundOpenChest != NULL) {
-		s3eFreeBase(soundOpenChest->buffer);
-		delete soundOpenChest;
-		soundOpenChest = NULL;
-	}
-	if(soundRestartLevel != NULL) {
-		s3eFreeBase(soundRestartLevel->buffer);
-		delete soundRestartLevel;
-		soundRestartLevel = NULL;
-	}
-	if(soundDoor != NULL) {
-		s3eFreeBase(soundDoor->buffer);
-		delete soundDoor;
-		soundDoor = NULL;
-	}
-	if(soundClick != NULL) {
-		s3eFreeBase(soundClick->buffer);
-		delete soundClick;
-		soundClick = NULL;
-	}
-	if(soundMapLocked != NULL) {
-		s3eFreeBase(soundMapLocked->buffer);
-		delete soundMapLocked;
-		soundMapLocked = NULL;
-	}
-	if(soundUnlockAchievement != NULL) {
-		s3eFreeBase(soundUnlockAchievement->buffer);
-		delete soundUnlockAchievement;
-		soundMapLocked = NULL;
-	}
+	unloadSound(soundKeyMove);
+	unloadSound(soundOpenChest);
+	unloadSound(soundRestartLevel);
+	unloadSound(soundDoor);
+	unloadSound(soundClick);
+	unloadSound(soundMapLocked);
+	unloadSound(soundUnlockAchievement);
+	soundKeyMove = NULL;
+	soundOpenChest = NULL;
+	soundRestartLevel = NULL;
+	soundDoor = NULL;
+	soundClick = NULL;
+	soundMapLocked = NULL;
+	soundUnlockAchievement = NULL;
+	if(bank != NULL)
+		delete bank;
+	bank = NULL;
 	IGLog("Sounds unloaded");
 }
 
-Sounds::Sound* Sounds::loadSound(const char* filename) {
+Sounds::Sound* Sounds::loadSound(const char* filename, int priority, int maxInstances, bool lazy) {
 	Sounds::Sound* sound = new Sounds::Sound();
+	sound->buffer = NULL;
+	sound->fileSize = 0;
+	sound->handle = -1;
+	sound->bankIndex = bank != NULL ? bank->find(filename) : -1;
+	sound->priority = priority;
+	sound->maxInstances = maxInstances;
+	strcpy(sound->fileName, filename);
+	if(sound->bankIndex >= 0) {
+		sound->fileSize = bank->getNumSamples(sound->bankIndex)*2;
+		if(lazy == false)
+			decodeSound(sound);
+		return sound;
+	}
+
 	s3eFile *fileHandle = s3eFileOpen(filename, "rb");
 	if (fileHandle) {
-	  strcpy(sound->fileName, filename);
 	  sound->fileSize = s3eFileGetSize(fileHandle);
 	  sound->buffer = (int16*)s3eMallocBase(sound->fileSize);
 	  memset(sound->buffer, 0, sound->fileSize);
 	  s3eFileRead(sound->buffer, sound->fileSize, 1, fileHandle);
 	  s3eFileClose(fileHandle);
+#ifndef __S3E__
+	  // upload once here instead of on every play, openal keeps its own copy
+	  sound->handle = s3eSoundBankRegister(sound->buffer, sound->fileSize/2, priority, maxInstances);
+	  s3eFreeBase(sound->buffer);
+	  sound->buffer = NULL;
+#endif
 	} else
 	  fprintf(stderr, "Error loading sound file: %s.\n", filename);
 	return sound;
 }
 
+bool Sounds::decodeSound(Sounds::Sound* sound) {
+	if(bank == NULL || sound->bankIndex < 0)
+		return false;
+	sound->buffer = (int16*)s3eMallocBase(sound->fileSize);
+	if(sound->buffer == NULL)
+		return false;
+	bank->decode(sound->bankIndex, sound->buffer);
+#ifndef __S3E__
+	// only openal's copy stays
+	sound->handle = s3eSoundBankRegister(sound->buffer, sound->fileSize/2, sound->priority, sound->maxInstances);
+	s3eFreeBase(sound->buffer);
+	sound->buffer = NULL;
+#endif
+	return true;
+}
+
+bool Sounds::isDecoded(Sounds::Sound* sound) {
+#ifdef __S3E__
+	return sound->buffer != NULL;
+#else
+	return sound->handle >= 0;
+#endif
+}
+
+void Sounds::releaseBank() {
+	if(bank == NULL)
+		return;
+	Sounds::Sound* sounds[] = { soundKeyMove, soundOpenChest, soundRestartLevel, soundDoor,
+		soundClick, soundMapLocked, soundUnlockAchievement };
+	for(int i=0; i<7; i++)
+		if(sounds[i] != NULL && sounds[i]->bankIndex >= 0 && isDecoded(sounds[i]) == false)
+			return;
+	delete bank;
+	bank = NULL;
+	IGLog("Sound bank released");
+}
+
+void Sounds::reportMemory() {
+	// against every sound read from its .raw, which on compat sat in the heap and in openal
+	Sounds::Sound* sounds[] = { soundKeyMove, soundOpenChest, soundRestartLevel, soundDoor,
+		soundClick, soundMapLocked, soundUnlockAchievement };
+	int32 resident = bank != NULL ? bank->getSize() : 0;
+	int32 raw = 0;
+	for(int i=0; i<7; i++) {
+		if(sounds[i] == NULL)
+			continue;
+		raw += sounds[i]->fileSize;
+		if(isDecoded(sounds[i]))
+			resident += sounds[i]->fileSize;
+	}
+#ifndef __S3E__
+	raw *= 2;
+#endif
+	char buffer[200];
+	sprintf(buffer, "Sounds resident: %d KB (all raw: %d KB)", resident/1024, raw/1024);
+	IGLog(buffer);
+}
+
+void Sounds::unloadSound(Sounds::Sound* sound) {
+	if(sound == NULL)
+		return;
+#ifndef __S3E__
+	s3eSoundBankUnregister(sound->handle);
+#endif
+	if(sound->buffer != NULL)
+		s3eFreeBase(sound->buffer);
+	delete sound;
+}
+
 void Sounds::playSound(Sounds::Sound* sound) {
-	if(Settings::getInstance()->soundEnabled == false)
+	if(Settings::getInstance()->soundEnabled == false || sound == NULL)
 		return;
+	if(isDecoded(sound) == false) {
+		if(decodeSound(sound) == false)
+			return;
+		releaseBank();
+	}
+#ifdef __S3E__
 	int channel = s3eSoundGetFreeChannel();
 	if(s3eSoundChannelPlay(channel, sound->buffer, sound->fileSize/2, 1, 0) == S3E_RESULT_ERROR) {
 		char buffer[200];
 		sprintf(buffer, "Error in s3eSoundChannelPlay: %s", s3eSoundGetErrorString());
 		IGLog(buffer);
 	}
+#else
+	// the bank picks the voice, and may drop the sound under a burst
+	s3eSoundBankPlay(sound->handle);
+#endif
 }
 
 // play sounds
@@ -165,11 +263,15 @@ void Sounds::startMusicMenu() {
 	
 	IGLog("Sounds starting menu music");
 	gameplayPlaying = false;
+#ifdef __S3E__
 	stopMusic();
 	if(s3eAudioIsCodecSupported(S3E_AUDIO_CODEC_MP3))
 		s3eAudioPlay("menu.mp3", 0);
 	else
 		IGLog("mp3 codec not available on this system");
+#else
+	s3eAudioCrossfade("menu.mp3", 0, MUSIC_CROSSFADE_MS);
+#endif
 }
 void Sounds::startMusicGameplay() {
 	if(Settings::getInstance()->musicEnabled == false)
@@ -180,6 +282,23 @@ void Sounds::startMusicGameplay() {
 
 	IGLog("Sounds starting gameplay music");
 	
+#ifndef __S3E__
+	// the tracks follow on from each other, so once they play there is nothing to change
+	if(gameplayPlaying && s3eAudioIsPlaying() == S3E_TRUE)
+		return;
+	gameplayPlaying = true;
+	gameplayStart = s3eTimerGetMs();
+
+	// all three in a random order, not starting with the one heard first last time
+	const char* tracks[3] = { "gameplay1.mp3", "gameplay2.mp3", "gameplay3.mp3" };
+	int first = gameplayMusicNum;
+	while(first == gameplayMusicNum)
+		first = rand()%3;
+	gameplayMusicNum = first;
+	int second = (first + 1 + rand()%2) % 3;
+	const char* playlist[3] = { tracks[first], tracks[second], tracks[3 - first - second] };
+	s3eAudioPlaylist(playlist, 3, MUSIC_CROSSFADE_MS);
+#else
 	// if gameplay music is already playing, only change song if it's been playing for a full minute
 	if(gameplayPlaying) {
 		if(s3eTimerGetMs() - gameplayStart <= 60000)
@@ -201,6 +320,7 @@ void Sounds::startMusicGameplay() {
 	}
 	if(s3eAudioIsCodecSupported(S3E_AUDIO_CODEC_MP3))
 		s3eAudioPlay(buffer, 0);
+#endif
 }
 
 void Sounds::stopMusic() {
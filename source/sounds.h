@@ -2,6 +2,8 @@
 #ifndef SOUNDS_H
 #define SOUNDS_H
 
+class SoundBank;
+
 class Sounds {
 public:
 	// return the instance
@@ -41,11 +43,23 @@ private:
 		int16* buffer;
 		int32 fileSize;
 		char fileName[256];
+		int handle; // in the compat sound bank
+		int bankIndex; // in sounds.bank, -1 when read from its own file
+		int priority;
+		int maxInstances;
 	};
 
 	// sound methods
-	Sounds::Sound* loadSound(const char* filename);
+	Sounds::Sound* loadSound(const char* filename, int priority, int maxInstances, bool lazy = false);
+	bool decodeSound(Sounds::Sound* sound);
+	bool isDecoded(Sounds::Sound* sound);
+	void releaseBank();
+	void reportMemory();
+	void unloadSound(Sounds::Sound* sound);
 	void playSound(Sounds::Sound* sound);
+
+	// the compressed sounds, kept until every lazy one is decoded
+	SoundBank* bank;
 	
 	// sound buffers
 	Sounds::Sound* soundKeyMove;
@@ -1,11 +1,13 @@
 #include "sqlite3_wrapper.h"
 #include <stdio.h>
+#include "ig2d/ig_profiler.h"
 
 #ifndef __S3E__
 extern const char *writePath (const char *file);
 #endif
 
 SQLite3Wrapper::SQLite3Wrapper(std::string tablename) {
+	IG_PROFILE("SQLite3Wrapper::open");
 	zErrMsg = 0;
 	rc = 0;
 	db_open = 0;
@@ -23,6 +25,7 @@ SQLite3Wrapper::SQLite3Wrapper(std::string tablename) {
 }
 
 int SQLite3Wrapper::exe(std::string s_exe) {
+	IG_PROFILE("SQLite3Wrapper::exe");
 	rc = sqlite3_get_table(
 		db,		       	/* An open database */
 		s_exe.c_str(),    	/* SQL to be executed */